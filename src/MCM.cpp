@@ -27,6 +27,9 @@
 #include "MCMInput.h"
 #include "MCMSerialization.h"
 #include "MCMTranslator.h"
+#include "MCMLog.h"
+#include "MCMTelemetry.h"
+#include "MCMPluginAPI.h"
 
 IDebugLog gLog;
 PluginHandle g_pluginHandle = kPluginHandle_Invalid;
@@ -35,6 +38,7 @@ F4SEScaleformInterface		*g_scaleform = NULL;
 F4SEPapyrusInterface		*g_papyrus = NULL;
 F4SEMessagingInterface		*g_messaging = NULL;
 F4SESerializationInterface	*g_serialization = NULL;
+F4SETaskInterface			*g_task = NULL;
 
 //-------------------------
 // Event Handlers
@@ -42,15 +46,21 @@ F4SESerializationInterface	*g_serialization = NULL;
 
 bool RegisterPapyrus(VirtualMachine *vm) {
 	PapyrusMCM::RegisterFuncs(vm);
-	_MESSAGE("Registered Papyrus native functions.");
+	MCM_LOG_MESSAGE("Registered Papyrus native functions.");
 
 	return true;
 }
 
 void OnF4SEMessage(F4SEMessagingInterface::Message* msg) {
     switch (msg->type) {
+        case F4SEMessagingInterface::kMessage_PostLoad:
+            // All plugins have registered their listeners by now.
+            MCMPluginAPI::Publish(g_messaging, g_pluginHandle);
+            break;
+
         case F4SEMessagingInterface::kMessage_GameLoaded:
             MCMInput::GetInstance().RegisterForInput(true);
+            MCMSerialization::Prefetch();
 
             // Inject translations
             BSScaleformTranslator* translator = (BSScaleformTranslator*)(*G::scaleformManager)->stateBag->GetStateAddRef(GFxState::kInterface_Translator);
@@ -83,8 +93,8 @@ bool F4SEPlugin_Query(const F4SEInterface * f4se, PluginInfo * info)
 {
 	gLog.OpenRelative(CSIDL_MYDOCUMENTS, "\\My Games\\Fallout4\\F4SE\\MCM.log");
 
-	_MESSAGE("MCM v%s", PLUGIN_VERSION_STRING);
-	_MESSAGE("MCM query");
+	MCM_LOG_MESSAGE("MCM v%s", PLUGIN_VERSION_STRING);
+	MCM_LOG_MESSAGE("MCM query");
 
 	// populate info structure
 	info->infoVersion =	PluginInfo::kInfoVersion;
@@ -116,28 +126,35 @@ bool F4SEPlugin_Query(const F4SEInterface * f4se, PluginInfo * info)
 	// Get the scaleform interface
 	g_scaleform = (F4SEScaleformInterface *)f4se->QueryInterface(kInterface_Scaleform);
 	if(!g_scaleform) {
-		_MESSAGE("couldn't get scaleform interface");
+		MCM_LOG_MESSAGE("couldn't get scaleform interface");
 		return false;
 	}
 
 	// Get the papyrus interface
 	g_papyrus = (F4SEPapyrusInterface *)f4se->QueryInterface(kInterface_Papyrus);
 	if (!g_papyrus) {
-		_MESSAGE("couldn't get papyrus interface");
+		MCM_LOG_MESSAGE("couldn't get papyrus interface");
 		return false;
 	}
 
 	// Get the messaging interface
 	g_messaging = (F4SEMessagingInterface *)f4se->QueryInterface(kInterface_Messaging);
 	if (!g_messaging) {
-		_MESSAGE("couldn't get messaging interface");
+		MCM_LOG_MESSAGE("couldn't get messaging interface");
 		return false;
 	}
 
 	// Get the serialization interface
 	g_serialization = (F4SESerializationInterface *)f4se->QueryInterface(kInterface_Serialization);
 	if (!g_serialization) {
-		_MESSAGE("couldn't get serialization interface");
+		MCM_LOG_MESSAGE("couldn't get serialization interface");
+		return false;
+	}
+
+	// Get the task interface
+	g_task = (F4SETaskInterface *)f4se->QueryInterface(kInterface_Task);
+	if (!g_task) {
+		MCM_LOG_MESSAGE("couldn't get task interface");
 		return false;
 	}
 
@@ -148,8 +165,12 @@ bool F4SEPlugin_Load(const F4SEInterface *f4se)
 {
     gLog.OpenRelative(CSIDL_MYDOCUMENTS, "\\My Games\\Fallout4\\F4SE\\MCM.log");
 
-    _MESSAGE("MCM v%s", PLUGIN_VERSION_STRING);
-    _MESSAGE("MCM load");
+    MCM_LOG_MESSAGE("MCM v%s", PLUGIN_VERSION_STRING);
+    MCM_LOG_MESSAGE("MCM load");
+
+    MCMLog::Start();
+
+    MCMTelemetry::ScopedSpan span("F4SEPlugin_Load");
 
     // Store plugin handle
     g_pluginHandle = f4se->GetPluginHandle();
@@ -158,28 +179,35 @@ bool F4SEPlugin_Load(const F4SEInterface *f4se)
     // Get the scaleform interface
     g_scaleform = (F4SEScaleformInterface*)f4se->QueryInterface(kInterface_Scaleform);
     if (!g_scaleform) {
-        _MESSAGE("couldn't get scaleform interface");
+        MCM_LOG_MESSAGE("couldn't get scaleform interface");
         return false;
     }
 
     // Get the papyrus interface
     g_papyrus = (F4SEPapyrusInterface*)f4se->QueryInterface(kInterface_Papyrus);
     if (!g_papyrus) {
-        _MESSAGE("couldn't get papyrus interface");
+        MCM_LOG_MESSAGE("couldn't get papyrus interface");
         return false;
     }
 
     // Get the messaging interface
     g_messaging = (F4SEMessagingInterface*)f4se->QueryInterface(kInterface_Messaging);
     if (!g_messaging) {
-        _MESSAGE("couldn't get messaging interface");
+        MCM_LOG_MESSAGE("couldn't get messaging interface");
         return false;
     }
 
     // Get the serialization interface
     g_serialization = (F4SESerializationInterface*)f4se->QueryInterface(kInterface_Serialization);
     if (!g_serialization) {
-        _MESSAGE("couldn't get serialization interface");
+        MCM_LOG_MESSAGE("couldn't get serialization interface");
+        return false;
+    }
+
+    // Get the task interface
+    g_task = (F4SETaskInterface*)f4se->QueryInterface(kInterface_Task);
+    if (!g_task) {
+        MCM_LOG_MESSAGE("couldn't get task interface");
         return false;
     }
 
@@ -200,7 +228,7 @@ bool F4SEPlugin_Load(const F4SEInterface *f4se)
     if (GetFileAttributes("Data\\MCM") == INVALID_FILE_ATTRIBUTES)
         CreateDirectory("Data\\MCM", NULL);
 
-    SettingStore::GetInstance().ReadSettings();
+    SettingStore::GetInstance().ReadSettingsAsync();
 
     return true;
 }
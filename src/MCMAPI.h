@@ -0,0 +1,74 @@
+#pragma once
+
+// Native interface to the MCM for other F4SE plugins.
+// This header has no dependencies beyond the F4SE basic types and may be copied into other projects.
+//
+// Once all plugins have loaded, the MCM dispatches a kMessage_Interface message to every plugin listening to the
+// "F4MCM" sender. The message data is a pointer to the Interface:
+//
+//     void OnMCMMessage(F4SEMessagingInterface::Message* msg)
+//     {
+//         if (msg->type == MCMAPI::kMessage_Interface && msg->dataLen == sizeof(MCMAPI::Interface*)) {
+//             MCMAPI::Interface* mcm = *(MCMAPI::Interface**)msg->data;
+//             if (mcm->version >= 1) g_mcm = mcm;
+//         }
+//     }
+//
+//     // In F4SEPlugin_Load:
+//     messaging->RegisterListener(pluginHandle, "F4MCM", OnMCMMessage);
+//
+// Settings are read from the MCM's live store, so values changed in the menu or by Papyrus are seen immediately and
+// no plugin needs to parse Data\MCM\Settings itself. New members are only ever appended to Interface, and version
+// is incremented when they are, so check version before using members added after version 1.
+namespace MCMAPI
+{
+	enum {
+		kMessage_Interface	= 'MCMI',
+		kInterfaceVersion	= 1,
+	};
+
+	enum SettingType {
+		kSettingType_None,
+		kSettingType_Bool,
+		kSettingType_Int,
+		kSettingType_Float,
+		kSettingType_String,
+	};
+
+	// Opaque reference to a setting. Valid for the lifetime of the process: GetSetting only returns handles once the MCM
+	// has finished reading settings, and settings are never removed or replaced after that.
+	typedef struct SettingHandleTag* SettingHandle;
+
+	// Called on the thread that changed the setting, after the new value has been stored.
+	typedef void (*SettingChangedCallback)(const char* modName, const char* settingName, void* userData);
+
+	struct Interface
+	{
+		UInt32	version;	// kInterfaceVersion of the MCM that published the interface.
+		UInt32	size;		// sizeof(Interface) of the MCM that published the interface.
+
+		// Resolves a setting by the mod and setting names used in Papyrus, e.g. ("MyMod", "bEnabled:Main").
+		// Names are case-insensitive. Returns nullptr if the setting does not exist.
+		// Waits for the MCM to finish reading settings if it has not yet done so; resolve handles once and keep them.
+		SettingHandle	(*GetSetting)(const char* modName, const char* settingName);
+
+		SettingType		(*GetSettingType)(SettingHandle setting);
+
+		// Return the current value without locking. The type must match GetSettingType.
+		bool			(*GetBool)(SettingHandle setting);
+		SInt32			(*GetInt)(SettingHandle setting);
+		float			(*GetFloat)(SettingHandle setting);
+
+		// Copies the current value into buffer, truncating it if necessary. Returns the length of the full value.
+		UInt32			(*GetString)(SettingHandle setting, char* buffer, UInt32 bufferSize);
+
+		// Registers a callback for changes to any setting of modName, or of every mod if modName is nullptr.
+		// Returns an ID for RemoveSettingListener.
+		UInt32			(*AddSettingListener)(const char* modName, SettingChangedCallback callback, void* userData);
+		void			(*RemoveSettingListener)(UInt32 listenerID);
+
+		// Retrieves the key a keybind is currently mapped to. Returns false if the keybind is not mapped.
+		// modifiers is a combination of 1 (Shift), 2 (Control) and 4 (Alt).
+		bool			(*GetKeybind)(const char* modName, const char* keybindID, UInt32* keycode, UInt8* modifiers);
+	};
+}
@@ -0,0 +1,55 @@
+#include "MCMArguments.h"
+
+#include "f4se/PapyrusArgs.h"
+#include "f4se/PapyrusVM.h"
+#include "f4se/PapyrusScaleformAdapter.h"
+#include "f4se/ScaleformValue.h"
+
+#include "MCMKeybinds.h"
+
+namespace MCMUtils
+{
+	VMValue* VMArgumentList::NewEntry(UInt32 index, VirtualMachine* vm)
+	{
+		Pack(vm);
+		VMValue* var = new VMValue;
+		m_packedData->arr.entries[index].SetVariable(var);
+		return var;
+	}
+
+	void VMArgumentList::Set(UInt32 index, GFxValue* value, VirtualMachine* vm)
+	{
+		PlatformAdapter::ConvertScaleformValue(NewEntry(index, vm), value, vm);
+	}
+
+	void VMArgumentList::Set(UInt32 index, ActionParameters* param, VirtualMachine* vm)
+	{
+		VMValue* entry = NewEntry(index, vm);
+		switch (param->paramType) {
+			case ActionParameters::kType_Int:
+				PackValue(entry, &param->iValue, vm);
+				break;
+			case ActionParameters::kType_Bool:
+				PackValue(entry, &param->bValue, vm);
+				break;
+			case ActionParameters::kType_Float:
+				PackValue(entry, &param->fValue, vm);
+				break;
+			case ActionParameters::kType_String:
+				PackValue(entry, &param->sValue, vm);
+				break;
+		}
+	}
+
+	VMValue* VMArgumentList::Pack(VirtualMachine* vm)
+	{
+		if (!m_packedData) {
+			vm->CreateArray(&m_packed, m_count, &m_packedData);
+
+			m_packed.type.value = VMValue::kType_VariableArray;
+			m_packed.data.arr = m_packedData;
+		}
+
+		return &m_packed;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "f4se/PapyrusValue.h"
+
+class GFxValue;
+class VirtualMachine;
+struct ActionParameters;
+
+namespace MCMUtils
+{
+	// Argument storage for Papyrus function calls made by the MCM (CallQuestFunction, CallGlobalFunction and keybind actions).
+	//
+	// Each argument is converted into its own heap VMValue and stored in the Var[] array with SetVariable, so the
+	// array elements stay Variable-typed as CallFunctionNoWait_Internal expects. The values are handed over to the
+	// VM-owned array and never freed by the list, so a NoWait call that dispatches after the list is destroyed still
+	// sees valid arguments.
+	class VMArgumentList
+	{
+	public:
+		explicit VMArgumentList(UInt32 count) : m_count(count) {}
+
+		VMArgumentList(VMArgumentList const&)	= delete;
+		void operator=(VMArgumentList const&)	= delete;
+
+		UInt32		Count() const { return m_count; }
+
+		void Set(UInt32 index, GFxValue* value, VirtualMachine* vm);
+		void Set(UInt32 index, ActionParameters* param, VirtualMachine* vm);
+
+		// Returns the Var[] array holding the arguments, suitable for CallFunctionNoWait_Internal.
+		VMValue* Pack(VirtualMachine* vm);
+
+	private:
+		VMValue* NewEntry(UInt32 index, VirtualMachine* vm);	// Creates the array on first use.
+
+		UInt32						m_count;
+		VMValue						m_packed;		// Releases this list's reference to the array.
+		VMValue::ArrayData*			m_packedData = nullptr;
+	};
+}
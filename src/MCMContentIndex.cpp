@@ -0,0 +1,189 @@
+#include "MCMContentIndex.h"
+#include "MCMLog.h"
+
+#include <algorithm>
+
+#define MCM_CONFIG_DIRECTORY "Data\\MCM\\Config"
+
+//-------------------------
+// DirectoryWatcher
+//-------------------------
+
+bool DirectoryWatcher::Start(const char* directory)
+{
+	Stop();
+	m_pending = true;
+
+	HANDLE handle = FindFirstChangeNotification(directory, TRUE,
+		FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE);
+
+	if (handle == INVALID_HANDLE_VALUE) {
+		// Directory doesn't exist (yet). Poll() will keep reporting changes so that callers fall back to rescanning.
+		MCM_LOG_WARNING("Warning: Unable to watch %s for changes.", directory);
+		return false;
+	}
+
+	m_handle = handle;
+	return true;
+}
+
+void DirectoryWatcher::Stop()
+{
+	if (m_handle) {
+		FindCloseChangeNotification((HANDLE)m_handle);
+		m_handle = nullptr;
+	}
+}
+
+bool DirectoryWatcher::Poll()
+{
+	if (!m_handle) return true;
+
+	bool changed = m_pending;
+	m_pending = false;
+
+	// Drain all pending notifications. Several may be queued for a single logical change.
+	while (WaitForSingleObject((HANDLE)m_handle, 0) == WAIT_OBJECT_0) {
+		changed = true;
+		if (!FindNextChangeNotification((HANDLE)m_handle)) {
+			Stop();
+			return true;
+		}
+	}
+
+	return changed;
+}
+
+//-------------------------
+// MCMContentIndex
+//-------------------------
+
+namespace
+{
+	std::string ToLower(std::string str)
+	{
+		std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+		return str;
+	}
+
+	UInt64 ToStamp(const FILETIME & ft)
+	{
+		return ((UInt64)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	}
+
+	bool operator!=(const MCMContentIndex::ModContent & lhs, const MCMContentIndex::ModContent & rhs)
+	{
+		return lhs.name != rhs.name || lhs.flags != rhs.flags ||
+			lhs.configStamp != rhs.configStamp || lhs.settingsStamp != rhs.settingsStamp || lhs.keybindsStamp != rhs.keybindsStamp;
+	}
+}
+
+MCMContentIndex::MCMContentIndex()
+{
+	m_watcher.Start(MCM_CONFIG_DIRECTORY);
+}
+
+UInt32 MCMContentIndex::GetContentFlag(const char* filename)
+{
+	if (!filename) return 0;
+	if (_stricmp(filename, "config.json") == 0)		return kContent_Config;
+	if (_stricmp(filename, "settings.ini") == 0)	return kContent_Settings;
+	if (_stricmp(filename, "keybinds.json") == 0)	return kContent_Keybinds;
+	return 0;
+}
+
+std::vector<MCMContentIndex::ModContent> MCMContentIndex::GetMods()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Refresh();
+	return m_mods;
+}
+
+std::vector<std::string> MCMContentIndex::GetModsWithContent(UInt32 contentFlag)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Refresh();
+
+	std::vector<std::string> mods;
+	for (auto & mod : m_mods) {
+		if (mod.flags & contentFlag)
+			mods.push_back(mod.name);
+	}
+	return mods;
+}
+
+bool MCMContentIndex::GetMod(const std::string & modName, ModContent* contentOut)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Refresh();
+
+	auto itr = m_lookup.find(ToLower(modName));
+	if (itr == m_lookup.end()) return false;
+
+	if (contentOut) *contentOut = m_mods[itr->second];
+	return true;
+}
+
+void MCMContentIndex::Refresh()
+{
+	if (m_watcher.Poll()) {
+		Rebuild();
+	}
+}
+
+void MCMContentIndex::Rebuild()
+{
+	std::vector<ModContent> mods;
+
+	HANDLE hFind;
+	WIN32_FIND_DATA data;
+
+	hFind = FindFirstFile(MCM_CONFIG_DIRECTORY "\\*", &data);
+	if (hFind != INVALID_HANDLE_VALUE) {
+		do {
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+			if (!strcmp(data.cFileName, ".") || !strcmp(data.cFileName, "..")) continue;
+
+			ModContent mod = {};
+			mod.name = data.cFileName;
+			mods.push_back(mod);
+		} while (FindNextFile(hFind, &data));
+		FindClose(hFind);
+	}
+
+	// One enumeration per mod folder picks up presence and stamps for all tracked files at once.
+	for (auto & mod : mods) {
+		std::string searchPath = MCM_CONFIG_DIRECTORY "\\" + mod.name + "\\*";
+
+		hFind = FindFirstFile(searchPath.c_str(), &data);
+		if (hFind == INVALID_HANDLE_VALUE) continue;
+		do {
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+
+			UInt32 flag = GetContentFlag(data.cFileName);
+			UInt64 stamp = ToStamp(data.ftLastWriteTime);
+			switch (flag) {
+				case kContent_Config:	mod.configStamp		= stamp; break;
+				case kContent_Settings:	mod.settingsStamp	= stamp; break;
+				case kContent_Keybinds:	mod.keybindsStamp	= stamp; break;
+				default: continue;
+			}
+			mod.flags |= flag;
+		} while (FindNextFile(hFind, &data));
+		FindClose(hFind);
+	}
+
+	bool changed = mods.size() != m_mods.size();
+	for (size_t i = 0; !changed && i < mods.size(); i++) {
+		changed = mods[i] != m_mods[i];
+	}
+
+	if (changed) {
+		m_mods.swap(mods);
+		m_lookup.clear();
+		for (size_t i = 0; i < m_mods.size(); i++) {
+			m_lookup[ToLower(m_mods[i].name)] = i;
+		}
+		MCM_LOG_MESSAGE("Indexed %d MCM config folders.", m_mods.size());
+	}
+}
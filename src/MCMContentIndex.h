@@ -0,0 +1,81 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Tracks changes to a directory tree using FindFirstChangeNotification.
+class DirectoryWatcher
+{
+public:
+	DirectoryWatcher() {}
+	~DirectoryWatcher() { Stop(); }
+
+	DirectoryWatcher(DirectoryWatcher const&)	= delete;
+	void operator=(DirectoryWatcher const&)		= delete;
+
+	bool Start(const char* directory);
+	void Stop();
+
+	// Returns true if the watched tree has changed since the last call. Never blocks.
+	bool Poll();
+
+private:
+	void*	m_handle	= nullptr;
+	bool	m_pending	= true;		// Always report a change before the first scan.
+};
+
+// Shared index of the contents of Data\MCM\Config.
+// Built once and refreshed only when the directory watcher reports a change, so that repeated
+// queries (e.g. opening the menu) do not touch the filesystem.
+class MCMContentIndex
+{
+public:
+	static MCMContentIndex& GetInstance() {
+		static MCMContentIndex instance;
+		return instance;
+	}
+
+	enum ContentFlags {
+		kContent_Config		= (1 << 0),		// config.json
+		kContent_Settings	= (1 << 1),		// settings.ini
+		kContent_Keybinds	= (1 << 2),		// keybinds.json
+	};
+
+	struct ModContent
+	{
+		std::string	name;					// Folder name as it appears on disk.
+		UInt32		flags;					// ContentFlags
+		UInt64		configStamp;			// Last write time of each file, 0 if not present.
+		UInt64		settingsStamp;
+		UInt64		keybindsStamp;
+	};
+
+	// Returns a snapshot of all mod folders, in directory order.
+	std::vector<ModContent> GetMods();
+
+	// Returns the names of all mod folders that contain the specified content.
+	std::vector<std::string> GetModsWithContent(UInt32 contentFlag);
+
+	// Looks up a single mod folder (case-insensitive). Returns false if the folder does not exist.
+	bool GetMod(const std::string & modName, ModContent* contentOut);
+
+	// Returns the ContentFlags value for a well-known MCM filename, or 0 if the file is not tracked by the index.
+	static UInt32 GetContentFlag(const char* filename);
+
+private:
+	MCMContentIndex();
+
+	void Refresh();		// Rescans if the watcher reports a change. Caller must hold m_lock.
+	void Rebuild();
+
+	std::mutex							m_lock;
+	DirectoryWatcher					m_watcher;
+	std::vector<ModContent>				m_mods;
+	std::map<std::string, size_t>		m_lookup;	// Lowercase folder name -> index into m_mods.
+
+public:
+	MCMContentIndex(MCMContentIndex const&)	= delete;
+	void operator=(MCMContentIndex const&)	= delete;
+};
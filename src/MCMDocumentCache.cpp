@@ -0,0 +1,106 @@
+#include "MCMDocumentCache.h"
+
+#include <algorithm>
+
+UInt64 MCMDocumentCache::GetFileStamp(const std::string & path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &data)) return 0;
+
+	// Include the size so that two writes within the timestamp resolution are still told apart.
+	UInt64 stamp = ((UInt64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	return stamp ^ ((UInt64)data.nFileSizeLow << 1);
+}
+
+std::string MCMDocumentCache::MakeKey(const std::string & path, const char* typeName)
+{
+	std::string key = path;
+	std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+	std::replace(key.begin(), key.end(), '/', '\\');
+	key += '|';
+	key += typeName;
+	return key;
+}
+
+std::shared_ptr<const MCMDocumentCache::Document> MCMDocumentCache::Find(const std::string & key, UInt64 stamp)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	auto itr = m_entries.find(key);
+	if (itr == m_entries.end()) {
+		m_misses++;
+		return nullptr;
+	}
+
+	if (itr->second.stamp != stamp) {
+		// The file has changed on disk.
+		Remove(itr);
+		m_misses++;
+		return nullptr;
+	}
+
+	m_lru.splice(m_lru.begin(), m_lru, itr->second.lruPosition);
+	m_hits++;
+	return itr->second.document;
+}
+
+void MCMDocumentCache::Insert(const std::string & key, UInt64 stamp, std::shared_ptr<const Document> document)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	auto itr = m_entries.find(key);
+	if (itr != m_entries.end()) Remove(itr);
+
+	Entry entry;
+	entry.document		= document;
+	entry.stamp			= stamp;
+	entry.memoryUsage	= document->GetMemoryUsage() + sizeof(Entry) + key.size() * 2;
+
+	m_lru.push_front(key);
+	entry.lruPosition = m_lru.begin();
+	m_memoryUsage += entry.memoryUsage;
+	m_entries.emplace(key, std::move(entry));
+
+	Evict();
+}
+
+void MCMDocumentCache::Remove(std::unordered_map<std::string, Entry>::iterator itr)
+{
+	m_memoryUsage -= itr->second.memoryUsage;
+	m_lru.erase(itr->second.lruPosition);
+	m_entries.erase(itr);
+}
+
+void MCMDocumentCache::Evict()
+{
+	// Always keep the most recently used document, even if it alone exceeds the budget.
+	while (m_memoryUsage > kBudget && m_entries.size() > 1) {
+		Remove(m_entries.find(m_lru.back()));
+		m_evictions++;
+	}
+}
+
+void MCMDocumentCache::Invalidate(const std::string & path)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	std::string prefix = MakeKey(path, "");
+	for (auto itr = m_entries.begin(); itr != m_entries.end(); ) {
+		auto next = std::next(itr);
+		if (itr->first.compare(0, prefix.size(), prefix) == 0) Remove(itr);
+		itr = next;
+	}
+}
+
+MCMDocumentCache::Stats MCMDocumentCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	Stats stats;
+	stats.hits			= m_hits;
+	stats.misses		= m_misses;
+	stats.evictions		= m_evictions;
+	stats.documents		= m_entries.size();
+	stats.memoryUsage	= m_memoryUsage;
+	return stats;
+}
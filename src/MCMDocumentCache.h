@@ -0,0 +1,103 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+#include "MCMProfiler.h"
+
+// Process-wide cache of parsed MCM files (config.json, keybinds.json, Keybinds.json).
+// Each consumer stores its own parsed representation of a file, keyed by path and by the representation's type,
+// and validated against the file's stamp. Documents are shared by reference count, so evicting a document
+// never invalidates a reference that is still in use. When the memory budget is exceeded, the least recently
+// used documents are evicted.
+class MCMDocumentCache
+{
+public:
+	static MCMDocumentCache& GetInstance() {
+		static MCMDocumentCache instance;
+		return instance;
+	}
+
+	// Base class for cached representations.
+	struct Document
+	{
+		virtual ~Document() {}
+
+		// Approximate heap usage of the document, counted against the budget.
+		virtual size_t GetMemoryUsage() const = 0;
+	};
+
+	struct Stats
+	{
+		UInt32	hits;
+		UInt32	misses;
+		UInt32	evictions;
+		UInt32	documents;
+		size_t	memoryUsage;
+	};
+
+	// Returns the cached T for path if it was loaded from the same stamp. Otherwise calls load(path) and caches its result.
+	// T must derive from Document. load returns a std::shared_ptr<T>, or nullptr if the file could not be loaded,
+	// in which case nothing is cached.
+	template <typename T, typename Loader>
+	std::shared_ptr<const T> Get(const std::string & path, UInt64 stamp, Loader load)
+	{
+		std::string key = MakeKey(path, typeid(T).name());
+
+		std::shared_ptr<const Document> cached = Find(key, stamp);
+		if (cached) return std::static_pointer_cast<const T>(cached);
+
+		// Loaded without holding the lock. Concurrent misses on the same file may both load it; the last one is kept.
+		std::shared_ptr<T> loaded;
+		{
+			MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_DocumentCache);
+			loaded = load(path);
+		}
+		if (loaded) Insert(key, stamp, loaded);
+		return loaded;
+	}
+
+	// Returns the last write time of a file, or 0 if it does not exist.
+	static UInt64 GetFileStamp(const std::string & path);
+
+	// Drops every representation of the specified file.
+	void Invalidate(const std::string & path);
+
+	Stats GetStats();
+
+private:
+	MCMDocumentCache() {}
+
+	struct Entry
+	{
+		std::shared_ptr<const Document>		document;
+		UInt64								stamp;
+		size_t								memoryUsage;
+		std::list<std::string>::iterator	lruPosition;
+	};
+
+	static std::string MakeKey(const std::string & path, const char* typeName);
+
+	std::shared_ptr<const Document> Find(const std::string & key, UInt64 stamp);
+	void Insert(const std::string & key, UInt64 stamp, std::shared_ptr<const Document> document);
+	void Remove(std::unordered_map<std::string, Entry>::iterator itr);
+	void Evict();		// Caller must hold m_lock.
+
+	enum { kBudget = 4 * 1024 * 1024 };
+
+	std::mutex								m_lock;
+	std::unordered_map<std::string, Entry>	m_entries;
+	std::list<std::string>					m_lru;		// Most recently used first.
+	size_t									m_memoryUsage	= 0;
+	UInt32									m_hits			= 0;
+	UInt32									m_misses		= 0;
+	UInt32									m_evictions		= 0;
+
+public:
+	MCMDocumentCache(MCMDocumentCache const&)	= delete;
+	void operator=(MCMDocumentCache const&)		= delete;
+};
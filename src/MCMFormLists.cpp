@@ -0,0 +1,82 @@
+#include "MCMFormLists.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "f4se/GameForms.h"
+#include "f4se/GameRTTI.h"
+
+namespace MCMFormLists
+{
+	// Keyed by FormList form ID. Only accessed from the UI thread.
+	std::unordered_map<UInt32, NameList> s_nameCache;
+
+	// FNV-1a over the entry form IDs. Changes whenever an entry is added, removed or replaced.
+	UInt64 GetSignature(BGSListForm* formList)
+	{
+		UInt64 hash = 14695981039346656037ULL;
+		for (UInt32 i = 0; i < formList->forms.count; i++) {
+			TESForm* form = formList->forms.entries[i];
+			hash ^= form ? form->formID : 0;
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	NameList* GetNames(BGSListForm* formList)
+	{
+		NameList & list = s_nameCache[formList->formID];
+		UInt32 formCount = formList->forms.count;
+		UInt64 signature = GetSignature(formList);
+
+		if (list.signature != signature || list.names.size() != formCount) {
+			list.signature = signature;
+			list.names.clear();
+			list.lowerNames.clear();
+			list.names.reserve(formCount);
+
+			for (UInt32 i = 0; i < formCount; i++) {
+				TESForm* form = formList->forms.entries[i];
+				if (!form) {
+					list.names.push_back("");
+					continue;
+				}
+				TESFullName* fullname = DYNAMIC_CAST(form, TESForm, TESFullName);
+				list.names.push_back(fullname ? fullname->name.c_str() : form->GetEditorID());
+			}
+		}
+
+		return &list;
+	}
+
+	std::vector<UInt32> Find(NameList* list, const char* query, bool prefixOnly, UInt32 maxResults)
+	{
+		std::vector<UInt32> results;
+
+		if (list->lowerNames.size() != list->names.size()) {
+			list->lowerNames = list->names;
+			for (auto & name : list->lowerNames) {
+				std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+			}
+		}
+
+		std::string lowerQuery(query ? query : "");
+		std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+
+		for (UInt32 i = 0; i < list->lowerNames.size(); i++) {
+			const std::string & name = list->lowerNames[i];
+			bool match = prefixOnly ? name.compare(0, lowerQuery.size(), lowerQuery) == 0 : name.find(lowerQuery) != std::string::npos;
+			if (match) {
+				results.push_back(i);
+				if (maxResults > 0 && results.size() >= maxResults) break;
+			}
+		}
+
+		return results;
+	}
+
+	void Clear()
+	{
+		s_nameCache.clear();
+	}
+}
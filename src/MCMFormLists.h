@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class BGSListForm;
+
+// Caches display names for the entries of a FormList.
+// Names are rebuilt only when the list's entries change, so repeatedly opening a dropdown backed by a large
+// FormList does not cast every entry and copy its name again. The cache is cleared when a game is reverted.
+namespace MCMFormLists
+{
+	struct NameList
+	{
+		UInt64						signature;		// Hash of the entry form IDs at the time the names were built.
+		std::vector<std::string>	names;
+		std::vector<std::string>	lowerNames;		// Lowercase copies for searching. Built on first search.
+	};
+
+	// Returns the cached names for the specified FormList, rebuilding them if the list has changed.
+	NameList* GetNames(BGSListForm* formList);
+
+	// Finds entries whose name contains (or starts with, if prefixOnly is set) the query. Matching is case-insensitive.
+	// Returns the indices of at most maxResults matches, in list order. A maxResults of 0 means no limit.
+	std::vector<UInt32> Find(NameList* list, const char* query, bool prefixOnly, UInt32 maxResults);
+
+	// Drops all cached names.
+	void Clear();
+}
@@ -0,0 +1,99 @@
+#include "MCMIOWorker.h"
+#include "MCMLog.h"
+
+#include <chrono>
+
+MCMIOWorker::MCMIOWorker()
+{
+	m_thread = std::thread(&MCMIOWorker::Run, this);
+	m_threadId = m_thread.get_id();
+}
+
+MCMIOWorker::~MCMIOWorker()
+{
+	// Runs at process exit, after the game's threads have stopped submitting work.
+	Shutdown();
+}
+
+bool MCMIOWorker::Enqueue(Priority priority, std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_stopping) return false;
+		m_lanes[priority].push_back(std::move(task));
+		m_pending++;
+	}
+	m_wake.notify_one();
+	return true;
+}
+
+bool MCMIOWorker::Dequeue(std::function<void()>* task)
+{
+	for (auto & lane : m_lanes) {
+		if (!lane.empty()) {
+			*task = std::move(lane.front());
+			lane.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void MCMIOWorker::Run()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	while (true) {
+		std::function<void()> task;
+		m_wake.wait(lock, [this, &task]() { return m_stopping || Dequeue(&task); });
+		if (!task) return;
+
+		m_busy = true;
+		lock.unlock();
+		try {
+			task();
+		} catch (...) {
+			MCM_LOG_WARNING("Warning: An MCM I/O task failed.");
+		}
+		lock.lock();
+		m_busy = false;
+
+		// Also wakes Shutdown, which waits for the in-progress task.
+		m_pending--;
+		m_idle.notify_all();
+	}
+}
+
+void MCMIOWorker::Flush()
+{
+	if (IsWorkerThread()) return;
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_idle.wait(lock, [this]() { return m_pending == 0 || m_stopping; });
+}
+
+void MCMIOWorker::Shutdown()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	if (m_stopping) return;
+	m_stopping = true;
+	m_wake.notify_all();
+
+	// The worker is not joined: at process exit it may already have been terminated. Let a task that is in progress
+	// finish, so writes to the same file stay ordered, then run whatever is left here, in priority order.
+	m_idle.wait_for(lock, std::chrono::milliseconds(kShutdownTimeout), [this]() { return !m_busy; });
+
+	std::function<void()> task;
+	while (Dequeue(&task)) {
+		lock.unlock();
+		try {
+			task();
+		} catch (...) {
+			MCM_LOG_WARNING("Warning: An MCM I/O task failed.");
+		}
+		lock.lock();
+		m_pending--;
+	}
+
+	m_idle.notify_all();
+	if (m_thread.joinable()) m_thread.detach();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Background executor for MCM disk I/O.
+// Settings and keybind writes, and prefetches of MCM files, run on a single worker thread so that game threads
+// never wait on the disk. Tasks are taken from the highest-priority lane first and run in submission order within
+// a lane, so successive writes to the same file are applied in order. Callers that need a result wait on the
+// returned future. The queue is flushed when a game is saved and when the MCM closes; remaining tasks are also run
+// to completion on shutdown, but that runs at DLL detach and should not be relied on.
+class MCMIOWorker
+{
+public:
+	static MCMIOWorker& GetInstance() {
+		static MCMIOWorker instance;
+		return instance;
+	}
+
+	enum Priority {
+		kPriority_Interactive,		// Writes caused by the player, e.g. changing a setting in the menu.
+		kPriority_SaveCritical,		// Writes that accompany a game save.
+		kPriority_Prefetch,			// Speculative reads that warm caches.
+		kPriority_Count
+	};
+
+	// Queues a task and returns a future for its result. Tasks submitted from the worker thread itself run immediately,
+	// so a task may wait on the result of another without deadlocking.
+	template <typename F>
+	auto Submit(Priority priority, F task) -> std::future<decltype(task())>
+	{
+		typedef decltype(task()) Result;
+		std::shared_ptr<std::packaged_task<Result()>> packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+		std::future<Result> result = packaged->get_future();
+
+		if (IsWorkerThread() || !Enqueue(priority, [packaged]() { (*packaged)(); })) {
+			(*packaged)();
+		}
+		return result;
+	}
+
+	// Blocks until the queue is empty and no task is running. Tasks submitted by other threads while waiting are
+	// waited for as well. Returns immediately on the worker thread.
+	void Flush();
+
+	// Runs all remaining tasks on the calling thread and stops accepting new ones. Later submissions run synchronously.
+	void Shutdown();
+
+	bool IsWorkerThread() const { return std::this_thread::get_id() == m_threadId; }
+
+private:
+	MCMIOWorker();
+	~MCMIOWorker();
+
+	enum { kShutdownTimeout = 2000 };	// ms to wait for an in-progress task on shutdown.
+
+	bool Enqueue(Priority priority, std::function<void()> task);		// Returns false after shutdown.
+	bool Dequeue(std::function<void()>* task);							// Caller must hold m_lock.
+	void Run();
+
+	std::mutex							m_lock;
+	std::condition_variable				m_wake;
+	std::condition_variable				m_idle;
+	std::deque<std::function<void()>>	m_lanes[kPriority_Count];
+	UInt32								m_pending	= 0;		// Queued or running tasks.
+	bool								m_busy		= false;	// The worker is running a task.
+	bool								m_stopping	= false;
+	std::thread							m_thread;
+	std::thread::id						m_threadId;
+
+public:
+	MCMIOWorker(MCMIOWorker const&)		= delete;
+	void operator=(MCMIOWorker const&)	= delete;
+};
@@ -11,6 +11,8 @@
 
 #include "Globals.h"
 #include "Utils.h"
+#include "MCMArguments.h"
+#include "MCMLog.h"
 
 void MCMInput::RegisterForInput(bool bRegister)
 {
@@ -24,29 +26,14 @@ void MCMInput::RegisterForInput(bool bRegister)
 	} else {
 		if (bRegister) {
 			inputEvents->Push(inputHandler);
-			_MESSAGE("Registered for input events.");
+			MCM_LOG_MESSAGE("Registered for input events.");
 		}
 	}
 }
 
-void PackArgs(VMArray<VMVariable> & arguments, KeybindParameters & kp) {
-	for (int i = 0; i < kp.actionParams.size(); i++) {
-		VMVariable var;
-		switch (kp.actionParams[i].paramType) {
-			case ActionParameters::kType_Int:
-				var.Set(&kp.actionParams[i].iValue);
-				break;
-			case ActionParameters::kType_Bool:
-				var.Set(&kp.actionParams[i].bValue);
-				break;
-			case ActionParameters::kType_Float:
-				var.Set(&kp.actionParams[i].fValue);
-				break;
-			case ActionParameters::kType_String:
-				var.Set(&kp.actionParams[i].sValue);
-				break;
-		}
-		arguments.Push(&var);
+void PackArgs(MCMUtils::VMArgumentList & arguments, KeybindParameters & kp, VirtualMachine * vm) {
+	for (UInt32 i = 0; i < arguments.Count(); i++) {
+		arguments.Set(i, &kp.actionParams[i], vm);
 	}
 }
 
@@ -101,11 +88,15 @@ void MCMInput::OnButtonEvent(ButtonEvent * inputEvent)
 							{
 								TESForm* form = LookupFormByID(kp.targetFormID);
 								if (form) {
-									VMArray<VMVariable> arguments;
-									PackArgs(arguments, kp);
-									CallFunctionNoWait<TESForm>(form, kp.callbackName, arguments);
+									VirtualMachine * vm = (*G::gameVM)->m_virtualMachine;
+									MCMUtils::VMScript script(form);
+									if (script.m_identifier) {
+										MCMUtils::VMArgumentList arguments(kp.actionParams.size());
+										PackArgs(arguments, kp, vm);
+										CallFunctionNoWait_Internal(vm, 0, script.m_identifier, &kp.callbackName, arguments.Pack(vm));
+									}
 								} else {
-									_WARNING("Warning: Cannot call a function on a None form.");
+									MCM_LOG_RATE_LIMITED(MCMLog::kLevel_Warning, "Warning: Cannot call a function on a None form.");
 								}
 								break;
 							}
@@ -113,11 +104,9 @@ void MCMInput::OnButtonEvent(ButtonEvent * inputEvent)
 							{
 								if (strlen(kp.callbackName.c_str()) > 0) {
 									VirtualMachine * vm = (*G::gameVM)->m_virtualMachine;
-									VMArray<VMVariable> arguments;
-									PackArgs(arguments, kp);
-									VMValue args;
-									PackValue(&args, &arguments, vm);
-									CallGlobalFunctionNoWait_Internal(vm, 0, 0, &kp.scriptName, &kp.callbackName, &args);
+									MCMUtils::VMArgumentList arguments(kp.actionParams.size());
+									PackArgs(arguments, kp, vm);
+									CallGlobalFunctionNoWait_Internal(vm, 0, 0, &kp.scriptName, &kp.callbackName, arguments.Pack(vm));
 								}
 								break;
 							}
@@ -135,12 +124,12 @@ void MCMInput::OnButtonEvent(ButtonEvent * inputEvent)
 									UInt64 handle = PapyrusVM::GetHandleFromObject(form, TESForm::kTypeID);
 									SendPapyrusEvent1<BSFixedString>(handle, "ScriptObject", "OnControlDown", kp.keybindID);
 								} else {
-									_WARNING("Warning: Cannot send an event to a None form.");
+									MCM_LOG_RATE_LIMITED(MCMLog::kLevel_Warning, "Warning: Cannot send an event to a None form.");
 								}
 								break;
 							}
 							default:
-								_WARNING("Warning: Cannot execute a keybind with unknown action type.");
+								MCM_LOG_RATE_LIMITED(MCMLog::kLevel_Warning, "Warning: Cannot execute a keybind with unknown action type.");
 								break;
 						}
 						
@@ -183,7 +172,7 @@ void MCMInput::OnButtonEvent(ButtonEvent * inputEvent)
 									UInt64 handle = PapyrusVM::GetHandleFromObject(form, TESForm::kTypeID);
 									SendPapyrusEvent2<BSFixedString, float>(handle, "ScriptObject", "OnControlUp", kp.keybindID, timer);
 								} else {
-									_WARNING("Warning: Cannot send an event to a None form.");
+									MCM_LOG_RATE_LIMITED(MCMLog::kLevel_Warning, "Warning: Cannot send an event to a None form.");
 								}
 								break;
 							}
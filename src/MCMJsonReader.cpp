@@ -0,0 +1,336 @@
+#include "MCMJsonReader.h"
+
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+
+namespace MCMJson
+{
+	PullReader::PullReader(const char* begin, const char* end) : m_begin(begin), m_pos(begin), m_end(end)
+	{
+		// Skip a UTF-8 BOM.
+		if (m_end - m_pos >= 3 && (UInt8)m_pos[0] == 0xEF && (UInt8)m_pos[1] == 0xBB && (UInt8)m_pos[2] == 0xBF) {
+			m_pos += 3;
+		}
+	}
+
+	// Comments are skipped as whitespace, as jsoncpp does, since hand-written config files often contain them.
+	void PullReader::SkipWhitespace()
+	{
+		while (m_pos < m_end) {
+			if (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r') {
+				m_pos++;
+			} else if (*m_pos == '/' && m_end - m_pos >= 2 && m_pos[1] == '/') {
+				m_pos += 2;
+				while (m_pos < m_end && *m_pos != '\n') m_pos++;
+			} else if (*m_pos == '/' && m_end - m_pos >= 2 && m_pos[1] == '*') {
+				const char* start = m_pos;
+				m_pos += 2;
+				while (m_end - m_pos >= 2 && !(m_pos[0] == '*' && m_pos[1] == '/')) m_pos++;
+				if (m_end - m_pos < 2) {
+					// Unterminated comment.
+					m_pos = start;
+					Fail();
+					return;
+				}
+				m_pos += 2;
+			} else {
+				break;
+			}
+		}
+	}
+
+	bool PullReader::Fail()
+	{
+		if (!m_error) {
+			m_error			= true;
+			m_errorOffset	= m_pos - m_begin;
+		}
+		return false;
+	}
+
+	bool PullReader::Expect(char c)
+	{
+		SkipWhitespace();
+		if (m_pos >= m_end || *m_pos != c) return Fail();
+		m_pos++;
+		return true;
+	}
+
+	bool PullReader::ReadLiteral(const char* literal)
+	{
+		for (const char* c = literal; *c; c++, m_pos++) {
+			if (m_pos >= m_end || *m_pos != *c) return Fail();
+		}
+		return true;
+	}
+
+	PullReader::TokenType PullReader::Peek()
+	{
+		if (m_error) return kToken_Invalid;
+
+		SkipWhitespace();
+		if (m_pos >= m_end) return kToken_Invalid;
+
+		switch (*m_pos) {
+			case '{':	return kToken_Object;
+			case '[':	return kToken_Array;
+			case '"':	return kToken_String;
+			case 't':
+			case 'f':	return kToken_Bool;
+			case 'n':	return kToken_Null;
+			default:
+				if (*m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9')) return kToken_Number;
+				return kToken_Invalid;
+		}
+	}
+
+	bool PullReader::BeginObject()
+	{
+		if (m_error || m_first.size() >= kMaxDepth) return Fail();
+		if (!Expect('{')) return false;
+		m_first.push_back(true);
+		return true;
+	}
+
+	bool PullReader::BeginArray()
+	{
+		if (m_error || m_first.size() >= kMaxDepth) return Fail();
+		if (!Expect('[')) return false;
+		m_first.push_back(true);
+		return true;
+	}
+
+	bool PullReader::NextInContainer(char close)
+	{
+		if (m_error || m_first.empty()) return Fail();
+
+		SkipWhitespace();
+		if (m_pos < m_end && *m_pos == close) {
+			m_pos++;
+			m_first.pop_back();
+			return false;
+		}
+
+		if (m_first.back()) {
+			m_first.back() = false;
+		} else if (!Expect(',')) {
+			return false;
+		}
+		return true;
+	}
+
+	bool PullReader::NextMember(std::string* name)
+	{
+		if (!NextInContainer('}')) return false;
+		return ReadString(name) && Expect(':');
+	}
+
+	bool PullReader::NextElement()
+	{
+		return NextInContainer(']');
+	}
+
+	bool PullReader::ReadHex4(UInt32* value)
+	{
+		*value = 0;
+		for (int i = 0; i < 4; i++, m_pos++) {
+			if (m_pos >= m_end) return Fail();
+			char c = *m_pos;
+			*value <<= 4;
+			if		(c >= '0' && c <= '9')	*value |= c - '0';
+			else if (c >= 'a' && c <= 'f')	*value |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')	*value |= c - 'A' + 10;
+			else return Fail();
+		}
+		return true;
+	}
+
+	bool PullReader::ReadString(std::string* value)
+	{
+		if (m_error) return false;
+		if (!Expect('"')) return false;
+
+		value->clear();
+		while (true) {
+			// Copy runs of unescaped characters in one go.
+			const char* run = m_pos;
+			while (m_pos < m_end && *m_pos != '"' && *m_pos != '\\') m_pos++;
+			value->append(run, m_pos);
+
+			if (m_pos >= m_end) return Fail();
+			if (*m_pos++ == '"') return true;
+
+			if (m_pos >= m_end) return Fail();
+			switch (*m_pos++) {
+				case '"':	value->push_back('"');	break;
+				case '\\':	value->push_back('\\');	break;
+				case '/':	value->push_back('/');	break;
+				case 'b':	value->push_back('\b');	break;
+				case 'f':	value->push_back('\f');	break;
+				case 'n':	value->push_back('\n');	break;
+				case 'r':	value->push_back('\r');	break;
+				case 't':	value->push_back('\t');	break;
+				case 'u':
+				{
+					UInt32 codepoint;
+					if (!ReadHex4(&codepoint)) return false;
+
+					// Combine surrogate pairs.
+					if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+						UInt32 low;
+						if (m_end - m_pos < 2 || m_pos[0] != '\\' || m_pos[1] != 'u') return Fail();
+						m_pos += 2;
+						if (!ReadHex4(&low) || low < 0xDC00 || low > 0xDFFF) return Fail();
+						codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					// Encode as UTF-8.
+					if (codepoint < 0x80) {
+						value->push_back((char)codepoint);
+					} else if (codepoint < 0x800) {
+						value->push_back((char)(0xC0 | (codepoint >> 6)));
+						value->push_back((char)(0x80 | (codepoint & 0x3F)));
+					} else if (codepoint < 0x10000) {
+						value->push_back((char)(0xE0 | (codepoint >> 12)));
+						value->push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+						value->push_back((char)(0x80 | (codepoint & 0x3F)));
+					} else {
+						value->push_back((char)(0xF0 | (codepoint >> 18)));
+						value->push_back((char)(0x80 | ((codepoint >> 12) & 0x3F)));
+						value->push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+						value->push_back((char)(0x80 | (codepoint & 0x3F)));
+					}
+					break;
+				}
+				default:
+					return Fail();
+			}
+		}
+	}
+
+	bool PullReader::ReadNumber(double* value, bool* isInteger)
+	{
+		if (Peek() != kToken_Number) return Fail();
+
+		// Validate the number grammar before handing it to strtod, which accepts more than JSON does.
+		const char* start = m_pos;
+		bool integer = true;
+		if (*m_pos == '-') m_pos++;
+		if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') return Fail();
+		while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') m_pos++;
+		if (m_pos < m_end && *m_pos == '.') {
+			integer = false;
+			m_pos++;
+			if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') return Fail();
+			while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') m_pos++;
+		}
+		if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+			integer = false;
+			m_pos++;
+			if (m_pos < m_end && (*m_pos == '+' || *m_pos == '-')) m_pos++;
+			if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') return Fail();
+			while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') m_pos++;
+		}
+
+		// Numbers are short, so copy to a terminated buffer rather than relying on what follows the input.
+		char buf[64];
+		size_t length = m_pos - start;
+		if (length >= sizeof(buf)) {
+			std::string number(start, m_pos);
+			*value = strtod(number.c_str(), nullptr);
+		} else {
+			memcpy(buf, start, length);
+			buf[length] = 0;
+			*value = strtod(buf, nullptr);
+		}
+
+		if (isInteger) *isInteger = integer;
+		return true;
+	}
+
+	bool PullReader::ReadInt(SInt32* value)
+	{
+		double number;
+		if (!ReadNumber(&number)) return false;
+		if (number < -2147483648.0 || number > 2147483647.0) return Fail();
+		*value = (SInt32)number;
+		return true;
+	}
+
+	bool PullReader::ReadBool(bool* value)
+	{
+		if (Peek() != kToken_Bool) return Fail();
+		*value = (*m_pos == 't');
+		return ReadLiteral(*value ? "true" : "false");
+	}
+
+	bool PullReader::ReadNull()
+	{
+		if (Peek() != kToken_Null) return Fail();
+		return ReadLiteral("null");
+	}
+
+	bool PullReader::Skip()
+	{
+		switch (Peek()) {
+			case kToken_Object:
+			{
+				if (!BeginObject()) return false;
+				std::string name;
+				while (NextMember(&name)) {
+					if (!Skip()) return false;
+				}
+				return !m_error;
+			}
+			case kToken_Array:
+			{
+				if (!BeginArray()) return false;
+				while (NextElement()) {
+					if (!Skip()) return false;
+				}
+				return !m_error;
+			}
+			case kToken_String:
+			{
+				std::string value;
+				return ReadString(&value);
+			}
+			case kToken_Number:
+			{
+				double value;
+				return ReadNumber(&value);
+			}
+			case kToken_Bool:
+			{
+				bool value;
+				return ReadBool(&value);
+			}
+			case kToken_Null:
+				return ReadNull();
+			default:
+				return Fail();
+		}
+	}
+
+	bool PullReader::Finish()
+	{
+		if (m_error) return false;
+		SkipWhitespace();
+		if (m_pos != m_end || !m_first.empty()) return Fail();
+		return true;
+	}
+
+	bool ReadFile(const std::string & path, std::string* data)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return false;
+
+		std::streamoff size = file.tellg();
+		if (size < 0) return false;
+
+		data->resize((size_t)size);
+		file.seekg(0);
+		return size == 0 || (bool)file.read(&(*data)[0], size);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A minimal pull parser for JSON documents with a known schema.
+// Values are read in document order straight into the caller's structures, so no DOM is built and
+// missing members are simply never visited. Errors are sticky: once a read fails, every following read fails
+// and HasError() returns true. // and /* */ comments are allowed wherever whitespace is.
+//
+// Reading an object:
+//	if (reader.BeginObject()) {
+//		std::string name;
+//		while (reader.NextMember(&name)) {
+//			if (name == "id") reader.ReadString(&id);
+//			else reader.Skip();
+//		}
+//	}
+namespace MCMJson
+{
+	class PullReader
+	{
+	public:
+		enum TokenType {
+			kToken_Invalid,
+			kToken_Object,
+			kToken_Array,
+			kToken_String,
+			kToken_Number,
+			kToken_Bool,
+			kToken_Null,
+		};
+
+		PullReader(const char* begin, const char* end);
+
+		// Returns the type of the next value without consuming it.
+		TokenType Peek();
+
+		bool BeginObject();
+		bool NextMember(std::string* name);		// Returns false at the end of the object or on error.
+		bool BeginArray();
+		bool NextElement();						// Returns false at the end of the array or on error.
+
+		bool ReadString(std::string* value);
+		bool ReadNumber(double* value, bool* isInteger = nullptr);
+		bool ReadInt(SInt32* value);
+		bool ReadBool(bool* value);
+		bool ReadNull();
+
+		// Skips the next value, including any nested objects and arrays.
+		bool Skip();
+
+		// Returns true if the whole input was consumed without error.
+		bool Finish();
+
+		bool HasError() const { return m_error; }
+		size_t GetErrorOffset() const { return m_errorOffset; }
+
+	private:
+		enum { kMaxDepth = 256 };
+
+		void SkipWhitespace();
+		bool Fail();
+		bool Expect(char c);
+		bool ReadLiteral(const char* literal);
+		bool ReadHex4(UInt32* value);
+		bool NextInContainer(char close);
+
+		const char*			m_begin;
+		const char*			m_pos;
+		const char*			m_end;
+		std::vector<bool>	m_first;		// One entry per open container. Set until the first member or element is read.
+		bool				m_error			= false;
+		size_t				m_errorOffset	= 0;
+	};
+
+	// Reads a whole file into data. Returns false if the file could not be opened.
+	bool ReadFile(const std::string & path, std::string* data);
+}
@@ -1,9 +1,18 @@
 #include "MCMKeybinds.h"
 #include <fstream>
 #include <algorithm>
+#include <mutex>
 
 #include "Globals.h"
 #include "Utils.h"
+#include "MCMContentIndex.h"
+#include "MCMJsonReader.h"
+#include "MCMDocumentCache.h"
+#include "MCMLog.h"
+#include "MCMIOWorker.h"
+#include "MCMTelemetry.h"
+#include "MCMProfiler.h"
+#include "MCMStringPool.h"
 
 #include "json/json.h"
 
@@ -12,16 +21,32 @@
 
 KeybindManager g_keybindManager;
 
+namespace
+{
+	// Keybinds.json writes may be queued on different I/O lanes and so complete out of order.
+	// Each write records the keybind version of its snapshot, and older snapshots are skipped.
+	std::mutex	s_keybindsWriteLock;
+	UInt32		s_keybindsWrittenVersion = 0;
+}
+
 void KeybindManager::Register(Keybind key, KeybindParameters & params)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
 	Lock();
 	m_data[key] = params;
+	MarkChanged(key);
 	Release();
 }
 
 void KeybindManager::Clear(void)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
 	Lock();
+	for (auto & entry : m_data) {
+		MarkRemoved(entry.first);
+	}
 	m_data.clear();
 	Release();
 }
@@ -30,12 +55,15 @@ void KeybindManager::Clear(void)
 // Serialization
 //------------------------------
 
-std::string KeybindManager::ToJSON()
+std::string KeybindManager::ToJSON(UInt32* version)
 {
 	Lock();
 	std::vector<KeybindInfo> keybinds = GetAllKeybinds();
+	if (version) *version = m_version;
 	Release();
 
+	Json::ValueArena arena;
+	Json::ScopedValueArena arenaScope(arena);
 	Json::Value json;
 	json["version"] = 1;
 
@@ -54,177 +82,440 @@ std::string KeybindManager::ToJSON()
 	return jsonStr;
 }
 
-bool KeybindManager::FromJSON(std::string jsonStr)
+namespace
 {
-	try {
-		Json::Value json, keybinds;
-		Json::Reader reader;
-		reader.parse(jsonStr, json);
-
-		if (json["version"].asInt() < 1) return false;
-
-		keybinds = json["keybinds"];
-		if (!keybinds.isArray()) return false;
+	struct StoredKeybind
+	{
+		Keybind		kb;
+		std::string	modName;
+		std::string	keybindID;
+	};
+
+	// The registrations stored in Keybinds.json.
+	struct StoredKeybinds : public MCMDocumentCache::Document
+	{
+		SInt32						version = 0;
+		std::vector<StoredKeybind>	keybinds;
+
+		virtual size_t GetMemoryUsage() const override
+		{
+			size_t size = sizeof(*this) + keybinds.capacity() * sizeof(StoredKeybind);
+			for (auto & entry : keybinds) size += entry.modName.capacity() + entry.keybindID.capacity();
+			return size;
+		}
+	};
+
+	// Keybinds.json: {"version": 1, "keybinds": [{"keycode": 0, "modifiers": 0, "modName": "", "id": ""}, ...]}
+	bool ReadStoredKeybinds(const std::string & json, StoredKeybinds* stored)
+	{
+		MCMJson::PullReader reader(json.data(), json.data() + json.size());
+		std::string name;
+		if (reader.BeginObject()) {
+			while (reader.NextMember(&name)) {
+				if (name == "version") {
+					reader.ReadInt(&stored->version);
+				} else if (name == "keybinds" && reader.Peek() == MCMJson::PullReader::kToken_Array) {
+					reader.BeginArray();
+					while (reader.NextElement()) {
+						StoredKeybind entry = {};
+						SInt32 keycode = 0, modifiers = 0;
+						if (!reader.BeginObject()) break;
+						while (reader.NextMember(&name)) {
+							if		(name == "keycode")		reader.ReadInt(&keycode);
+							else if (name == "modifiers")	reader.ReadInt(&modifiers);
+							else if (name == "modName")		reader.ReadString(&entry.modName);
+							else if (name == "id")			reader.ReadString(&entry.keybindID);
+							else							reader.Skip();
+						}
+						entry.kb.keycode	= keycode;
+						entry.kb.modifiers	= modifiers;
+						stored->keybinds.push_back(entry);
+					}
+				} else {
+					reader.Skip();
+				}
+			}
+		}
 
-		for (int i = 0; i < keybinds.size(); i++) {
-			const Json::Value& keybind = keybinds[i];
+		if (!reader.Finish()) {
+			MCM_LOG_WARNING("Warning: Keybind storage deserialization failure at offset %u. No keybinds will be loaded.", (UInt32)reader.GetErrorOffset());
+			return false;
+		}
+		return true;
+	}
 
-			Keybind kb = {};
-			KeybindParameters kp = {};
+	std::shared_ptr<const StoredKeybinds> GetStoredKeybinds(const std::string & path, UInt64 stamp)
+	{
+		return MCMDocumentCache::GetInstance().Get<StoredKeybinds>(path, stamp, [](const std::string & path) {
+			std::shared_ptr<StoredKeybinds> stored;
+			std::string json;
+			if (!MCMJson::ReadFile(path, &json)) {
+				MCM_LOG_MESSAGE("Keybind storage could not be opened or does not exist.");
+				return stored;
+			}
 
-			kb.keycode		= keybind["keycode"].asInt();
-			kb.modifiers	= keybind["modifiers"].asInt();
+			stored = std::make_shared<StoredKeybinds>();
+			if (!ReadStoredKeybinds(json, stored.get())) stored.reset();
+			return stored;
+		});
+	}
 
-			std::string modName		= keybind["modName"].asString();
-			std::string keybindID	= keybind["id"].asString();
+	bool RegisterStoredKeybinds(KeybindManager & manager, const StoredKeybinds & stored)
+	{
+		if (stored.version < 1) return false;
 
-			if (GetKeybindData(modName, keybindID, &kp)) {
-				Lock();
-				m_data[kb] = kp;
-				Release();
+		for (auto & entry : stored.keybinds) {
+			KeybindParameters kp = {};
+			if (manager.GetKeybindData(entry.modName, entry.keybindID, &kp)) {
+				manager.Register(entry.kb, kp);
 			} else {
-				_MESSAGE("Warning: Failed to get keybind data for %s with keybind ID %s", modName.c_str(), keybindID.c_str());
+				MCM_LOG_WARNING("Warning: Failed to get keybind data for %s with keybind ID %s", entry.modName.c_str(), entry.keybindID.c_str());
 				continue;
 			}
 		}
 
 		return true;
-	} catch (...) {
-		_WARNING("Warning: Keybind storage deserialization failure. No keybinds will be loaded.");
+	}
+}
+
+bool KeybindManager::FromJSON(std::string jsonStr)
+{
+	StoredKeybinds stored;
+	if (!ReadStoredKeybinds(jsonStr, &stored)) return false;
+
+	return RegisterStoredKeybinds(*this, stored);
+}
+
+bool KeybindManager::FromFile(const std::string & path)
+{
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
+	UInt64 stamp = MCMDocumentCache::GetFileStamp(path);
+	if (!stamp) {
+		MCM_LOG_MESSAGE("Keybind storage could not be opened or does not exist.");
 		return false;
 	}
+
+	// Keybinds.json is re-read on every save load. It only changes when keybinds are committed, so the parsed
+	// registrations are normally shared with the previous load.
+	std::shared_ptr<const StoredKeybinds> stored = GetStoredKeybinds(path, stamp);
+
+	if (!stored) return false;
+	return RegisterStoredKeybinds(*this, *stored);
 }
 
-void KeybindManager::CommitKeybinds()
+void KeybindManager::CommitKeybinds(MCMIOWorker::Priority priority)
 {
 	if (m_keybindsDirty) {
 		// Save keybinds only if the data has changed.
-		LARGE_INTEGER countStart, countEnd, frequency;
-		QueryPerformanceCounter(&countStart);
-		QueryPerformanceFrequency(&frequency);
-
-		Lock();
+		// The registrations are serialized here so that the file matches the state at the time of the call.
+		// Only the write happens on the I/O worker.
+		std::string jsonStr;
+		UInt32 version;
 		try {
-			_MESSAGE("Serializing keybinds...");
+			jsonStr = ToJSON(&version);
+			m_keybindsDirty = false;
+		} catch (...) {
+			MCM_LOG_MESSAGE("Warning: An error occurred when serializing keybinds.");
+			return;
+		}
+
+		MCMIOWorker::GetInstance().Submit(priority, [jsonStr, version]() {
+			std::lock_guard<std::mutex> lock(s_keybindsWriteLock);
+			if (version < s_keybindsWrittenVersion) return;
+			s_keybindsWrittenVersion = version;
+
+			MCMTelemetry::ScopedSpan span("KeybindManager::WriteKeybinds");
+
+			MCM_LOG_MESSAGE("Serializing keybinds...");
 			if (GetFileAttributes("Data\\MCM\\Settings") == INVALID_FILE_ATTRIBUTES)
 				CreateDirectory("Data\\MCM\\Settings", NULL);
 			std::ofstream file("Data\\MCM\\Settings\\Keybinds.json");
-			std::string jsonStr = ToJSON();
 			file << jsonStr;
 			file.close();
-			m_keybindsDirty = false;
-		} catch (...) {
-			_MESSAGE("Warning: An error occurred when serializing keybinds.");
-		}
-		Release();
+			if (file.fail()) {
+				MCM_LOG_MESSAGE("Warning: An error occurred when serializing keybinds.");
+			}
+
+			// The stamp may not change if the file is rewritten with the same size within the timestamp resolution.
+			MCMDocumentCache::GetInstance().Invalidate("Data\\MCM\\Settings\\Keybinds.json");
 
-		QueryPerformanceCounter(&countEnd);
-		_MESSAGE("Elapsed: %llu ms.", (countEnd.QuadPart - countStart.QuadPart) / (frequency.QuadPart / 1000));
+			MCM_LOG_MESSAGE("Elapsed: %.3f ms.", span.GetElapsed() / 1000.0);
+		});
 	}
 }
 
-bool KeybindManager::GetKeybindData(std::string modName, std::string keybindID, KeybindParameters * kp)
+namespace
 {
-	// Check if we've already cached the data.
-	std::string keyName = modName + keybindID;
-	std::transform(keyName.begin(), keyName.end(), keyName.begin(), ::tolower);
-	if (m_keybindData.count(keyName) == 0) {
-		try {
-			// Not in the cache. Load from disk.
-			auto idx = modName.find_last_of('.');	// Strip trailing .esp / .esm
-			std::string filePath = "Data\\MCM\\Config\\" + modName.substr(0, idx) + "\\keybinds.json";
-			_MESSAGE("Loading keybind definitions for %s", modName.c_str());
-			std::ifstream file(filePath);
-			if (file.is_open()) {
-				Json::Value json, keybinds;
-				Json::Reader reader;
-				reader.parse(file, json);
-
-				keybinds = json["keybinds"];
-				if (!keybinds.isArray()) return false;
-
-				for (int i = 0; i < keybinds.size(); i++) {
-					const Json::Value& keybind = keybinds[i];
-
-					KeybindParameters kp = {};
-					kp.modName		= json["modName"].asCString();
-					kp.keybindID	= keybind["id"].asCString();
-					kp.keybindDesc	= keybind["desc"].asCString();
-					//kp.flags		= keybind["flags"].asInt();
-					kp.type			= -1;
-
-					std::string typeStr = keybind["action"]["type"].asString();
-					if		(typeStr == "CallFunction")			kp.type = KeybindParameters::kType_CallFunction;
-					else if (typeStr == "CallGlobalFunction")	kp.type = KeybindParameters::kType_CallGlobalFunction;
-					else if (typeStr == "RunConsoleCommand")	kp.type = KeybindParameters::kType_RunConsoleCommand;
-					else if (typeStr == "SendEvent")			kp.type = KeybindParameters::kType_SendEvent;
-
-					switch (kp.type) {
-						case KeybindParameters::kType_CallFunction:
-						{
-							TESForm* form = MCMUtils::GetFormFromIdentifier(keybind["action"]["form"].asString());
-							if (form) {
-								kp.targetFormID = form->formID;
-								kp.callbackName = keybind["action"]["function"].asCString();
-
-								Json::Value actionParams = keybind["action"]["params"];
-								if (!actionParams.isNull()) SetActionParams(actionParams, kp);
-							} else {
-								// Invalid form.
-								continue;
-							}
-							break;
-						}
-						case KeybindParameters::kType_CallGlobalFunction:
-						{
-							kp.scriptName = keybind["action"]["script"].asCString();
-							kp.callbackName = keybind["action"]["function"].asCString();
-
-							Json::Value actionParams = keybind["action"]["params"];
-							if (!actionParams.isNull()) SetActionParams(actionParams, kp);
-							
-							break;
-						}
-						case KeybindParameters::kType_RunConsoleCommand:
-						{
-							kp.callbackName = keybind["action"]["command"].asCString();
-							break;
-						}
-						case KeybindParameters::kType_SendEvent:
-						{
-							TESForm* form = MCMUtils::GetFormFromIdentifier(keybind["action"]["form"].asString());
-							if (form) {
-								kp.targetFormID = form->formID;
-							} else {
-								// Invalid form.
-								continue;
-							}
-							break;
-						}
-						default:
-						{
-							_WARNING("Warning: Cannot deserialize invalid keybind action type %s.", typeStr.c_str());
-							continue;
-							break;
-						}
+	// A keybind definition as it appears in keybinds.json, before forms are resolved.
+	struct KeybindDefinition
+	{
+		std::string						id;
+		std::string						desc;
+		std::string						type;
+		std::string						form;
+		std::string						function;
+		std::string						script;
+		std::string						command;
+		std::vector<ActionParameters>	params;
+	};
+
+	void ReadActionParams(MCMJson::PullReader & reader, std::vector<ActionParameters> & params)
+	{
+		if (reader.Peek() != MCMJson::PullReader::kToken_Array) {
+			reader.Skip();
+			return;
+		}
+
+		reader.BeginArray();
+		while (reader.NextElement()) {
+			ActionParameters ap;
+			switch (reader.Peek()) {
+				case MCMJson::PullReader::kToken_Number:
+				{
+					double value;
+					bool isInteger;
+					reader.ReadNumber(&value, &isInteger);
+					if (isInteger && value >= -2147483648.0 && value <= 2147483647.0) {
+						ap.paramType = ActionParameters::kType_Int;
+						ap.iValue = (SInt32)value;
+					} else {
+						ap.paramType = ActionParameters::kType_Float;
+						ap.fValue = (float)value;
 					}
+					break;
+				}
+				case MCMJson::PullReader::kToken_Bool:
+					ap.paramType = ActionParameters::kType_Bool;
+					reader.ReadBool(&ap.bValue);
+					break;
+				case MCMJson::PullReader::kToken_String:
+				{
+					std::string value;
+					reader.ReadString(&value);
+					ap.paramType = ActionParameters::kType_String;
+					ap.sValue = value.c_str();
+					break;
+				}
+				default:
+					// Unknown value type
+					MCM_LOG_WARNING("Cannot register unknown parameter value type: %d", reader.Peek());
+					reader.Skip();
+					break;
+			}
+			if (ap.paramType != ActionParameters::kType_None) {
+				params.push_back(ap);
+			}
+		}
+	}
 
-					std::string keyName = json["modName"].asString() + keybind["id"].asString();
-					std::transform(keyName.begin(), keyName.end(), keyName.begin(), ::tolower);
-					m_keybindData[keyName] = kp;
+	void ReadAction(MCMJson::PullReader & reader, KeybindDefinition & definition)
+	{
+		if (reader.Peek() != MCMJson::PullReader::kToken_Object) {
+			reader.Skip();
+			return;
+		}
+
+		std::string name;
+		reader.BeginObject();
+		while (reader.NextMember(&name)) {
+			if		(name == "type")		reader.ReadString(&definition.type);
+			else if (name == "form")		reader.ReadString(&definition.form);
+			else if (name == "function")	reader.ReadString(&definition.function);
+			else if (name == "script")		reader.ReadString(&definition.script);
+			else if (name == "command")		reader.ReadString(&definition.command);
+			else if (name == "params")		ReadActionParams(reader, definition.params);
+			else							reader.Skip();
+		}
+	}
+
+	// The keybind definitions of one mod, as parsed from its keybinds.json.
+	struct KeybindDefinitionFile : public MCMDocumentCache::Document
+	{
+		std::string						modName;
+		std::vector<KeybindDefinition>	definitions;
+
+		virtual size_t GetMemoryUsage() const override
+		{
+			size_t size = sizeof(*this) + modName.capacity() + definitions.capacity() * sizeof(KeybindDefinition);
+			for (auto & definition : definitions) {
+				size += definition.id.capacity() + definition.desc.capacity() + definition.type.capacity() + definition.form.capacity() +
+					definition.function.capacity() + definition.script.capacity() + definition.command.capacity() +
+					definition.params.capacity() * sizeof(ActionParameters);
+			}
+			return size;
+		}
+	};
+
+	// keybinds.json: {"modName": "", "keybinds": [{"id": "", "desc": "", "action": {"type": "", ...}}, ...]}
+	bool ReadKeybindDefinitions(const std::string & json, std::string* modName, std::vector<KeybindDefinition>* definitions)
+	{
+		MCMJson::PullReader reader(json.data(), json.data() + json.size());
+		std::string name;
+		bool hasKeybinds = false;
+
+		if (reader.BeginObject()) {
+			while (reader.NextMember(&name)) {
+				if (name == "modName") {
+					reader.ReadString(modName);
+				} else if (name == "keybinds" && reader.Peek() == MCMJson::PullReader::kToken_Array) {
+					hasKeybinds = true;
+					reader.BeginArray();
+					while (reader.NextElement()) {
+						KeybindDefinition definition;
+						if (!reader.BeginObject()) break;
+						while (reader.NextMember(&name)) {
+							if		(name == "id")		reader.ReadString(&definition.id);
+							else if (name == "desc")	reader.ReadString(&definition.desc);
+							else if (name == "action")	ReadAction(reader, definition);
+							else						reader.Skip();
+						}
+						definitions->push_back(std::move(definition));
+					}
+				} else {
+					reader.Skip();
 				}
-			} else {
+			}
+		}
+
+		return reader.Finish() && hasKeybinds;
+	}
+
+	std::shared_ptr<const KeybindDefinitionFile> GetKeybindDefinitionFile(const MCMContentIndex::ModContent & content)
+	{
+		std::string filePath = "Data\\MCM\\Config\\" + content.name + "\\keybinds.json";
+		const std::string & modName = content.name;
+
+		return MCMDocumentCache::GetInstance().Get<KeybindDefinitionFile>(filePath, content.keybindsStamp, [&modName](const std::string & path) {
+			MCM_LOG_MESSAGE("Loading keybind definitions for %s", modName.c_str());
+
+			std::shared_ptr<KeybindDefinitionFile> file;
+			std::string json;
+			if (!MCMJson::ReadFile(path, &json)) {
 				// Keybinds file doesn't exist.
-				return false;
+				return file;
 			}
-		} catch (...) {
-			_WARNING("Warning: Failed to parse malformed keybind definition file for mod %s.", modName.c_str());
+
+			file = std::make_shared<KeybindDefinitionFile>();
+			if (!ReadKeybindDefinitions(json, &file->modName, &file->definitions)) {
+				MCM_LOG_WARNING("Warning: Failed to parse malformed keybind definition file for mod %s.", modName.c_str());
+				file.reset();
+			}
+			return file;
+		});
+	}
+}
+
+void KeybindManager::PrefetchKeybinds(const std::string & storagePath)
+{
+	MCMIOWorker & worker = MCMIOWorker::GetInstance();
+
+	worker.Submit(MCMIOWorker::kPriority_Prefetch, [storagePath]() {
+		UInt64 stamp = MCMDocumentCache::GetFileStamp(storagePath);
+		if (stamp) GetStoredKeybinds(storagePath, stamp);
+	});
+
+	for (auto & mod : MCMContentIndex::GetInstance().GetMods()) {
+		if (!(mod.flags & MCMContentIndex::kContent_Keybinds)) continue;
+		worker.Submit(MCMIOWorker::kPriority_Prefetch, [mod]() {
+			GetKeybindDefinitionFile(mod);
+		});
+	}
+}
+
+bool KeybindManager::GetKeybindData(std::string modName, std::string keybindID, KeybindParameters * kp)
+{
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
+	// Check if we've already cached the data. Names are matched case-insensitively by the string pool.
+	// Lookup names are only found, not interned, so requests for unknown keybinds do not grow the pool.
+	MCMStringPool& pool = MCMStringPool::GetInstance();
+	UInt64 key = pool.FindKey(modName, keybindID);
+	if (m_keybindData.count(key) == 0) {
+		// Not in the cache. Load from disk.
+		auto idx = modName.find_last_of('.');	// Strip trailing .esp / .esm
+		std::string modFolder = modName.substr(0, idx);
+
+		// Skip the disk probe entirely for mods that don't ship keybind definitions.
+		MCMContentIndex::ModContent content;
+		if (!MCMContentIndex::GetInstance().GetMod(modFolder, &content) || !(content.flags & MCMContentIndex::kContent_Keybinds))
 			return false;
+
+		// Lookups for keybind IDs that are no longer defined miss m_keybindData every time, so share the parsed
+		// file rather than re-reading it for each of them. Usually already prefetched by PrefetchKeybinds.
+		std::shared_ptr<const KeybindDefinitionFile> file = GetKeybindDefinitionFile(content);
+
+		if (!file) return false;
+
+		const std::string & definitionModName = file->modName;
+		for (auto & definition : file->definitions) {
+			KeybindParameters kp = {};
+			kp.modName		= definitionModName.c_str();
+			kp.keybindID	= definition.id.c_str();
+			kp.keybindDesc	= definition.desc.c_str();
+			kp.type			= -1;
+
+			const std::string & typeStr = definition.type;
+			if		(typeStr == "CallFunction")			kp.type = KeybindParameters::kType_CallFunction;
+			else if (typeStr == "CallGlobalFunction")	kp.type = KeybindParameters::kType_CallGlobalFunction;
+			else if (typeStr == "RunConsoleCommand")	kp.type = KeybindParameters::kType_RunConsoleCommand;
+			else if (typeStr == "SendEvent")			kp.type = KeybindParameters::kType_SendEvent;
+
+			switch (kp.type) {
+				case KeybindParameters::kType_CallFunction:
+				{
+					TESForm* form = MCMUtils::GetFormFromIdentifier(definition.form);
+					if (form) {
+						kp.targetFormID = form->formID;
+						kp.callbackName = definition.function.c_str();
+						kp.actionParams = definition.params;
+					} else {
+						// Invalid form.
+						continue;
+					}
+					break;
+				}
+				case KeybindParameters::kType_CallGlobalFunction:
+				{
+					kp.scriptName = definition.script.c_str();
+					kp.callbackName = definition.function.c_str();
+					kp.actionParams = definition.params;
+					break;
+				}
+				case KeybindParameters::kType_RunConsoleCommand:
+				{
+					kp.callbackName = definition.command.c_str();
+					break;
+				}
+				case KeybindParameters::kType_SendEvent:
+				{
+					TESForm* form = MCMUtils::GetFormFromIdentifier(definition.form);
+					if (form) {
+						kp.targetFormID = form->formID;
+					} else {
+						// Invalid form.
+						continue;
+					}
+					break;
+				}
+				default:
+				{
+					MCM_LOG_WARNING("Warning: Cannot deserialize invalid keybind action type %s.", typeStr.c_str());
+					continue;
+					break;
+				}
+			}
+
+			m_keybindData[MCMStringPool::MakeKey(pool.Intern(definitionModName), pool.Intern(definition.id))] = kp;
 		}
+
+		// The names are interned now if the file defines them.
+		key = pool.FindKey(modName, keybindID);
 	}
 
-	if (m_keybindData.count(keyName) > 0) {
-		*kp = m_keybindData[keyName];
+	auto itr = m_keybindData.find(key);
+	if (itr != m_keybindData.end()) {
+		*kp = itr->second;
 		return true;
 	} else {
 		// The keybind doesn't exist anymore.
@@ -232,38 +523,19 @@ bool KeybindManager::GetKeybindData(std::string modName, std::string keybindID,
 	}
 }
 
-void KeybindManager::SetActionParams(Json::Value & actionParams, KeybindParameters & kp)
+bool KeybindManager::FindKeybind(const char* modName, const char* keybindID, Keybind* kb)
 {
-	if (actionParams.isArray()) {
-		for (int i = 0; i < actionParams.size(); i++) {
-			ActionParameters ap;
-			switch (actionParams[i].type()) {
-			case Json::intValue:
-				ap.paramType = ActionParameters::kType_Int;
-				ap.iValue = actionParams[i].asInt();
-				break;
-			case Json::booleanValue:
-				ap.paramType = ActionParameters::kType_Bool;
-				ap.bValue = actionParams[i].asBool();
-				break;
-			case Json::realValue:
-				ap.paramType = ActionParameters::kType_Float;
-				ap.fValue = actionParams[i].asFloat();
-				break;
-			case Json::stringValue:
-				ap.paramType = ActionParameters::kType_String;
-				ap.sValue = actionParams[i].asCString();
-				break;
-			default:
-				// Unknown value type
-				_MESSAGE("Cannot register unknown parameter value type: %s", actionParams[i].type());
-				break;
-			}
-			if (ap.paramType != ActionParameters::kType_None) {
-				kp.actionParams.push_back(ap);
-			}
+	bool found = false;
+	Lock();
+	for (RegMap::iterator iter = m_data.begin(); iter != m_data.end(); iter++) {
+		if (_stricmp(iter->second.modName.c_str(), modName) == 0 && _stricmp(iter->second.keybindID.c_str(), keybindID) == 0) {
+			*kb = iter->first;
+			found = true;
+			break;
 		}
 	}
+	Release();
+	return found;
 }
 
 KeybindInfo KeybindManager::GetKeybind(BSFixedString modName, BSFixedString keybindID)
@@ -284,33 +556,9 @@ KeybindInfo KeybindManager::GetKeybind(Keybind kb)
 	ki.keycode = kb.keycode;
 	ki.modifiers = kb.modifiers;
 
-	if (m_data.find(kb) != m_data.end()) {
-		ki.keybindType = KeybindInfo::kType_MCM;
-		ki.keybindID = m_data[kb].keybindID;
-		ki.keybindDesc = m_data[kb].keybindDesc;
-		ki.modName = m_data[kb].modName;
-		ki.type = m_data[kb].type;
-		ki.flags = m_data[kb].flags;
-		ki.callbackName = m_data[kb].callbackName;
-
-		switch (ki.type) {
-			case KeybindParameters::kType_CallFunction:
-			case KeybindParameters::kType_SendEvent:
-			{
-				ki.callTarget = MCMUtils::GetIdentifierFromFormID(m_data[kb].targetFormID).c_str();
-				break;
-			}
-			case KeybindParameters::kType_CallGlobalFunction:
-			{
-				ki.callTarget = m_data[kb].scriptName;
-				break;
-			}
-			case KeybindParameters::kType_RunConsoleCommand:
-			{
-				ki.callTarget = m_data[kb].callbackName;
-				break;
-			}
-		}
+	auto iter = m_data.find(kb);
+	if (iter != m_data.end()) {
+		return GetKeybindInfo(iter->first, iter->second);
 	} else {
 		// Not in registered keybinds. Check game keybinds.
 		if (kb.keycode > 0) {
@@ -348,19 +596,92 @@ KeybindInfo KeybindManager::GetKeybind(Keybind kb)
 std::vector<KeybindInfo> KeybindManager::GetAllKeybinds()
 {
 	std::vector<KeybindInfo> keybinds;
+	keybinds.reserve(m_data.size());
 	for (RegMap::iterator iter = m_data.begin(); iter != m_data.end(); iter++) {
-		KeybindInfo ki = GetKeybind(iter->first);
-		keybinds.push_back(ki);
+		keybinds.push_back(GetKeybindInfo(iter->first, iter->second));
 	}
 	return keybinds;
 }
 
+UInt32 KeybindManager::GetKeybindsSince(UInt32 version, std::vector<KeybindInfo> & changed, std::vector<Keybind> & removed)
+{
+	for (auto & entry : m_changeVersions) {
+		if (entry.second > version) {
+			auto iter = m_data.find(entry.first);
+			if (iter != m_data.end()) {
+				changed.push_back(GetKeybindInfo(iter->first, iter->second));
+			}
+		}
+	}
+
+	// A client with no prior state has nothing to remove.
+	if (version > 0) {
+		for (auto & entry : m_removedVersions) {
+			if (entry.second > version) {
+				removed.push_back(entry.first);
+			}
+		}
+	}
+
+	return m_version;
+}
+
+KeybindInfo KeybindManager::GetKeybindInfo(const Keybind & kb, const KeybindParameters & kp)
+{
+	KeybindInfo ki = {};
+	ki.keybindType = KeybindInfo::kType_MCM;
+	ki.keycode = kb.keycode;
+	ki.modifiers = kb.modifiers;
+	ki.keybindID = kp.keybindID;
+	ki.keybindDesc = kp.keybindDesc;
+	ki.modName = kp.modName;
+	ki.type = kp.type;
+	ki.flags = kp.flags;
+	ki.callbackName = kp.callbackName;
+
+	switch (ki.type) {
+		case KeybindParameters::kType_CallFunction:
+		case KeybindParameters::kType_SendEvent:
+		{
+			ki.callTarget = MCMUtils::GetIdentifierFromFormID(kp.targetFormID).c_str();
+			break;
+		}
+		case KeybindParameters::kType_CallGlobalFunction:
+		{
+			ki.callTarget = kp.scriptName;
+			break;
+		}
+		case KeybindParameters::kType_RunConsoleCommand:
+		{
+			ki.callTarget = kp.callbackName;
+			break;
+		}
+	}
+
+	return ki;
+}
+
+void KeybindManager::MarkChanged(const Keybind & kb)
+{
+	m_changeVersions[kb] = ++m_version;
+	m_removedVersions.erase(kb);
+}
+
+void KeybindManager::MarkRemoved(const Keybind & kb)
+{
+	m_removedVersions[kb] = ++m_version;
+	m_changeVersions.erase(kb);
+}
+
 bool KeybindManager::RegisterKeybind(Keybind kb, BSFixedString modName, BSFixedString keybindID)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
 	KeybindParameters kp = {};
 	if (GetKeybindData(modName.c_str(), keybindID.c_str(), &kp)) {
 		Lock();
 		m_data[kb] = kp;
+		MarkChanged(kb);
 		Release();
 		m_keybindsDirty = true;
 		return true;
@@ -371,8 +692,11 @@ bool KeybindManager::RegisterKeybind(Keybind kb, BSFixedString modName, BSFixedS
 
 bool KeybindManager::ClearKeybind(BSFixedString modName, BSFixedString keybindID)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
 	for (RegMap::iterator iter = m_data.begin(); iter != m_data.end(); iter++) {
 		if (iter->second.modName == modName && iter->second.keybindID == keybindID) {
+			MarkRemoved(iter->first);
 			m_data.erase(iter);
 			m_keybindsDirty = true;
 			return true;
@@ -383,8 +707,11 @@ bool KeybindManager::ClearKeybind(BSFixedString modName, BSFixedString keybindID
 
 bool KeybindManager::ClearKeybind(Keybind kb)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
 	auto iter = m_data.find(kb);
 	if (iter != m_data.end()) {
+		MarkRemoved(iter->first);
 		m_data.erase(iter);
 		m_keybindsDirty = true;
 		return true;
@@ -395,12 +722,16 @@ bool KeybindManager::ClearKeybind(Keybind kb)
 
 bool KeybindManager::RemapKeybind(BSFixedString modName, BSFixedString keybindID, Keybind newKeybind)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Keybinds);
+
 	for (RegMap::iterator iter = m_data.begin(); iter != m_data.end(); iter++) {
 		if (iter->second.modName == modName && iter->second.keybindID == keybindID) {
 			Keybind oldKeybind = iter->first;
 			if (oldKeybind == newKeybind) return false;
 			m_data[newKeybind] = iter->second;
 			m_data.erase(iter);
+			MarkRemoved(oldKeybind);
+			MarkChanged(newKeybind);
 			m_keybindsDirty = true;
 			return true;
 		}
@@ -1,12 +1,10 @@
 #pragma once
+#include <unordered_map>
 #include <vector>
 #include "f4se/PapyrusEvents.h"
 #include "f4se/GameTypes.h"
 
-// Forward-declaration
-namespace Json {
-	class Value;
-}
+#include "MCMIOWorker.h"
 
 class Keybind
 {
@@ -127,16 +125,22 @@ public:
 	bool RegisterKeybind(Keybind kb, BSFixedString modName, BSFixedString keybindID);	// Returns true if the keybind was registered. False if keybind definition could not be located.
 
 	// Serialization
-	std::string ToJSON();
+	std::string ToJSON(UInt32* version = nullptr);	// Optionally retrieves the keybind version the JSON was taken at.
 	bool FromJSON(std::string jsonStr);
-	void CommitKeybinds();	// Saves registered keybinds to disk if data was changed. (m_keybindsDirty)
+	bool FromFile(const std::string & path);	// Loads Keybinds.json. The parsed file is shared through MCMDocumentCache.
+	void CommitKeybinds(MCMIOWorker::Priority priority = MCMIOWorker::kPriority_Interactive);	// Saves registered keybinds to disk on the I/O worker if data was changed. (m_keybindsDirty)
+	void PrefetchKeybinds(const std::string & storagePath);	// Reads and parses Keybinds.json and all keybinds.json files on the I/O worker.
 	bool GetKeybindData(std::string modName, std::string keybindID, KeybindParameters* kp);		// Retrieves keybind data from Config\ModName\keybinds.json
-	void SetActionParams(Json::Value & actionParams, KeybindParameters & kp);
+	bool FindKeybind(const char* modName, const char* keybindID, Keybind* kb);	// Retrieves the key a keybind is mapped to. Names are case-insensitive.
 
 	// Not thread-safe. Explicitly lock before calling these.
 	KeybindInfo GetKeybind(BSFixedString modName, BSFixedString keybindID);
 	KeybindInfo GetKeybind(Keybind kb);
 	std::vector<KeybindInfo> GetAllKeybinds();
+
+	// Returns the current keybind version. Entries added or changed after the specified version are appended to changed,
+	// and keybinds removed after it are appended to removed. Pass 0 to retrieve all keybinds.
+	UInt32 GetKeybindsSince(UInt32 version, std::vector<KeybindInfo> & changed, std::vector<Keybind> & removed);
 	
 	// Returns true if successfully cleared. False if the keybind did not exist.
 	bool ClearKeybind(BSFixedString modName, BSFixedString keybindID);
@@ -149,9 +153,19 @@ public:
 	bool m_keybindsDirty = false;
 
 private:
-	// Maps a concatentation of modName+keybindID to keybind parameters.
+	// Maps MCMStringPool::MakeKey(modName, keybindID) to keybind parameters.
 	// Data is lazy-loaded. Mod keybind data is loaded from disk into this map when first requested and cached here for future fast lookup.
-	std::map<std::string, KeybindParameters> m_keybindData;
+	std::unordered_map<UInt64, KeybindParameters> m_keybindData;
+
+	// Change tracking for GetKeybindsSince. m_version is incremented on every modification to m_data.
+	// Each registered keybind records the version at which it was last changed; removed keybinds are kept as tombstones.
+	UInt32						m_version = 0;
+	std::map<Keybind, UInt32>	m_changeVersions;
+	std::map<Keybind, UInt32>	m_removedVersions;
+
+	KeybindInfo GetKeybindInfo(const Keybind & kb, const KeybindParameters & kp);
+	void MarkChanged(const Keybind & kb);
+	void MarkRemoved(const Keybind & kb);
 
 };
 
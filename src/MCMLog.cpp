@@ -0,0 +1,231 @@
+#include "MCMLog.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace MCMLog
+{
+	namespace
+	{
+		enum {
+			kSlotCount			= 1024,		// Must be a power of two.
+			kMessageLength		= 256,		// Longer messages bypass the buffer and are written directly.
+			kRateLimit			= 10,		// Messages per call site per window.
+			kRateWindow			= 1000,		// ms
+			kFlushInterval		= 50,		// ms
+			kDrainLockTimeout	= 100,		// ms. Bounds the wait when flushing from a crash handler.
+		};
+
+		// Bounded multi-producer, single-consumer queue. Each slot's sequence number tells producers and the consumer
+		// whether the slot is free or holds a message for the current lap.
+		struct Slot
+		{
+			std::atomic<size_t>	sequence;
+			Level				level;
+			char				text[kMessageLength];
+		};
+
+		Slot					s_slots[kSlotCount];
+		std::atomic<size_t>		s_enqueuePos	{ 0 };
+		size_t					s_dequeuePos	= 0;		// Only modified while holding s_drainLock.
+		std::atomic<UInt32>		s_dropped		{ 0 };
+
+		std::atomic<bool>		s_running		{ false };
+		std::atomic_flag		s_drainLock		= ATOMIC_FLAG_INIT;
+		std::thread				s_writer;
+
+		LPTOP_LEVEL_EXCEPTION_FILTER s_previousFilter = nullptr;
+
+		struct SlotInitializer
+		{
+			SlotInitializer()
+			{
+				for (size_t i = 0; i < kSlotCount; i++) s_slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		} s_slotInitializer;
+
+		void WriteLine(Level level, const char* text)
+		{
+			switch (level) {
+				case kLevel_Debug:		_DMESSAGE("%s", text);	break;
+				case kLevel_Message:	_MESSAGE("%s", text);	break;
+				case kLevel_Warning:	_WARNING("%s", text);	break;
+				case kLevel_Error:		_ERROR("%s", text);		break;
+			}
+		}
+
+		bool AcquireDrainLock(bool wait)
+		{
+			ULONGLONG start = GetTickCount64();
+			while (s_drainLock.test_and_set(std::memory_order_acquire)) {
+				if (!wait || GetTickCount64() - start > kDrainLockTimeout) return false;
+				std::this_thread::yield();
+			}
+			return true;
+		}
+
+		// Writes every message that has been fully enqueued. Caller must hold the drain lock, which also serializes
+		// every use of IDebugLog.
+		void Drain()
+		{
+			while (true) {
+				Slot & slot = s_slots[s_dequeuePos & (kSlotCount - 1)];
+				if (slot.sequence.load(std::memory_order_acquire) != s_dequeuePos + 1) break;
+
+				WriteLine(slot.level, slot.text);
+				slot.sequence.store(s_dequeuePos + kSlotCount, std::memory_order_release);
+				s_dequeuePos++;
+			}
+
+			UInt32 dropped = s_dropped.exchange(0);
+			if (dropped) {
+				_WARNING("Warning: %d log messages were dropped because the log buffer was full.", dropped);
+			}
+		}
+
+		void WriterThread()
+		{
+			while (s_running) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(kFlushInterval));
+				if (AcquireDrainLock(false)) {
+					Drain();
+					s_drainLock.clear(std::memory_order_release);
+				}
+			}
+		}
+
+		LONG WINAPI CrashFilter(EXCEPTION_POINTERS* exceptionInfo)
+		{
+			// Make sure everything logged up to the crash reaches the file.
+			Flush();
+			return s_previousFilter ? s_previousFilter(exceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+		}
+
+		// Returns false if the message should be suppressed.
+		bool CheckRateLimit(CallSite* site, UInt32* suppressed)
+		{
+			UInt64 now = GetTickCount64();
+			UInt64 windowStart = site->windowStart.load(std::memory_order_relaxed);
+			if (now - windowStart >= kRateWindow && site->windowStart.compare_exchange_strong(windowStart, now)) {
+				site->count = 0;
+				*suppressed = site->suppressed.exchange(0);
+			}
+
+			if (++site->count > kRateLimit) {
+				site->suppressed++;
+				return false;
+			}
+			return true;
+		}
+
+		// Writes a message on the calling thread, after everything already in the buffer so the log stays in order.
+		// Used before Start and after Shutdown, for warnings and errors, which must never be dropped, and for
+		// messages too long for a slot.
+		void WriteDirect(Level level, UInt32 suppressed, const char* fmt, va_list args)
+		{
+			std::string text;
+			va_list argsCopy;
+			va_copy(argsCopy, args);
+			int length = _vscprintf(fmt, argsCopy);
+			va_end(argsCopy);
+			if (length > 0) {
+				text.resize(length + 1);
+				vsnprintf_s(&text[0], text.size(), _TRUNCATE, fmt, args);
+				text.resize(length);
+			}
+
+			// While the writer thread is running it always releases the lock, so keep waiting rather than lose the message.
+			while (!AcquireDrainLock(true)) {
+				if (!s_running) return;
+			}
+			Drain();
+			if (suppressed) _MESSAGE("(%d similar messages suppressed)", suppressed);
+			WriteLine(level, text.c_str());
+			s_drainLock.clear(std::memory_order_release);
+		}
+	}
+
+	void Start()
+	{
+		if (s_running.exchange(true)) return;
+		s_writer = std::thread(WriterThread);
+		s_previousFilter = SetUnhandledExceptionFilter(CrashFilter);
+		atexit(Shutdown);
+	}
+
+	void Shutdown()
+	{
+		if (!s_running.exchange(false)) return;
+
+		// At process exit the writer thread may already have been terminated, so it is not joined.
+		if (s_writer.joinable()) s_writer.detach();
+		Flush();
+	}
+
+	void Flush()
+	{
+		// Gives up if the lock is stuck, e.g. because the writer thread died while holding it.
+		if (!AcquireDrainLock(true)) return;
+		Drain();
+		s_drainLock.clear(std::memory_order_release);
+	}
+
+	void Write(CallSite* site, Level level, const char* fmt, ...)
+	{
+		UInt32 suppressed = 0;
+		if (site && !CheckRateLimit(site, &suppressed)) return;
+
+		va_list args;
+		va_start(args, fmt);
+
+		if (!s_running || level >= kLevel_Warning) {
+			WriteDirect(level, suppressed, fmt, args);
+			va_end(args);
+			return;
+		}
+
+		// Format before claiming a slot so a message that does not fit can still be written in full.
+		char text[kMessageLength];
+		int length = 0;
+		if (suppressed) {
+			length = _snprintf_s(text, sizeof(text), _TRUNCATE, "(%d similar messages suppressed) ", suppressed);
+			if (length < 0) length = 0;
+		}
+		va_list argsCopy;
+		va_copy(argsCopy, args);
+		bool truncated = vsnprintf_s(text + length, sizeof(text) - length, _TRUNCATE, fmt, argsCopy) < 0;
+		va_end(argsCopy);
+
+		if (truncated) {
+			WriteDirect(level, suppressed, fmt, args);
+			va_end(args);
+			return;
+		}
+		va_end(args);
+
+		// Claim a slot.
+		size_t pos = s_enqueuePos.load(std::memory_order_relaxed);
+		Slot* slot;
+		while (true) {
+			slot = &s_slots[pos & (kSlotCount - 1)];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+			if (diff == 0) {
+				if (s_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			} else if (diff < 0) {
+				// Full. Never block the caller.
+				s_dropped++;
+				return;
+			} else {
+				pos = s_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		strcpy_s(slot->text, text);
+		slot->level = level;
+		slot->sequence.store(pos + 1, std::memory_order_release);
+	}
+}
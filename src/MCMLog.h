@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+
+// Asynchronous logging for the whole plugin.
+// Messages are formatted by the caller into a fixed-size lock-free ring buffer and written to MCM.log by a
+// background thread, so logging never waits on disk I/O. Warnings, errors and messages too long for the buffer are
+// written synchronously instead, so they are never dropped or truncated. The buffer is flushed synchronously on
+// shutdown and when the process crashes.
+//
+// IDebugLog is not thread-safe, so all logging in the plugin must go through the MCM_LOG_* macros rather than
+// calling _MESSAGE and friends directly. MCMLog makes sure only one thread writes to the log at a time.
+// Hot paths that may log on every frame or key press use MCM_LOG_RATE_LIMITED, which limits each call site to
+// kRateLimit messages per second.
+namespace MCMLog
+{
+	enum Level {
+		kLevel_Debug,
+		kLevel_Message,
+		kLevel_Warning,
+		kLevel_Error,
+	};
+
+	// Rate limiting state for a single call site.
+	struct CallSite
+	{
+		std::atomic<UInt64>	windowStart	{ 0 };
+		std::atomic<UInt32>	count		{ 0 };
+		std::atomic<UInt32>	suppressed	{ 0 };
+	};
+
+	// Starts the background writer. Messages logged before this are written synchronously.
+	void Start();
+
+	// Writes all buffered messages and stops the background writer.
+	void Shutdown();
+
+	// Writes all buffered messages on the calling thread.
+	void Flush();
+
+	// site may be nullptr, in which case the message is not rate limited.
+	void Write(CallSite* site, Level level, const char* fmt, ...);
+}
+
+#define MCM_LOG(level, fmt, ...)				MCMLog::Write(nullptr, level, fmt, __VA_ARGS__)
+#define MCM_LOG_RATE_LIMITED(level, fmt, ...)	do { static MCMLog::CallSite _mcmLogSite; MCMLog::Write(&_mcmLogSite, level, fmt, __VA_ARGS__); } while (0)
+#define MCM_LOG_DEBUG(fmt, ...)		MCM_LOG(MCMLog::kLevel_Debug, fmt, __VA_ARGS__)
+#define MCM_LOG_MESSAGE(fmt, ...)	MCM_LOG(MCMLog::kLevel_Message, fmt, __VA_ARGS__)
+#define MCM_LOG_WARNING(fmt, ...)	MCM_LOG(MCMLog::kLevel_Warning, fmt, __VA_ARGS__)
+#define MCM_LOG_ERROR(fmt, ...)		MCM_LOG(MCMLog::kLevel_Error, fmt, __VA_ARGS__)
@@ -0,0 +1,297 @@
+#include "MCMPageValues.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "f4se/ScaleformValue.h"
+#include "f4se/ScaleformMovie.h"
+#include "f4se/PapyrusScaleformAdapter.h"
+#include "f4se/GameData.h"
+#include "f4se/GameRTTI.h"
+
+#include "json/json.h"
+
+#include "Globals.h"
+#include "Utils.h"
+#include "SettingStore.h"
+#include "MCMContentIndex.h"
+#include "MCMDocumentCache.h"
+#include "MCMLog.h"
+
+namespace MCMPageValues
+{
+	enum SourceType {
+		kSource_None,
+		kSource_ModSettingBool,
+		kSource_ModSettingInt,
+		kSource_ModSettingFloat,
+		kSource_ModSettingString,
+		kSource_GlobalValue,
+		kSource_PropertyValue,
+	};
+
+	struct ValueBinding
+	{
+		UInt32		index;			// Position of the control in the page's content array.
+		SourceType	sourceType;
+		std::string	id;				// ModSetting: setting name. Otherwise unused.
+		std::string	sourceForm;		// GlobalValue / PropertyValue: form identifier.
+		std::string	scriptName;		// PropertyValue: optional script name.
+		std::string	propertyName;	// PropertyValue: property name.
+	};
+
+	struct PageBindings
+	{
+		std::string					pageName;
+		UInt32						controlCount;
+		std::vector<ValueBinding>	bindings;
+	};
+
+	struct ModBindings : public MCMDocumentCache::Document
+	{
+		std::string					modName;	// The modName declared in config.json. Used as the ModSetting key.
+		PageBindings				rootPage;
+		std::vector<PageBindings>	pages;
+
+		virtual size_t GetMemoryUsage() const override
+		{
+			size_t size = sizeof(*this) + modName.capacity() + GetMemoryUsage(rootPage) + pages.capacity() * sizeof(PageBindings);
+			for (auto & page : pages) size += GetMemoryUsage(page);
+			return size;
+		}
+
+		static size_t GetMemoryUsage(const PageBindings & page)
+		{
+			size_t size = page.pageName.capacity() + page.bindings.capacity() * sizeof(ValueBinding);
+			for (auto & binding : page.bindings) {
+				size += binding.id.capacity() + binding.sourceForm.capacity() + binding.scriptName.capacity() + binding.propertyName.capacity();
+			}
+			return size;
+		}
+	};
+
+	SourceType GetSourceType(const std::string & sourceType)
+	{
+		if (sourceType == "ModSettingBool")			return kSource_ModSettingBool;
+		if (sourceType == "ModSettingInt")			return kSource_ModSettingInt;
+		if (sourceType == "ModSettingFloat")		return kSource_ModSettingFloat;
+		if (sourceType == "ModSettingString")		return kSource_ModSettingString;
+		if (sourceType == "GlobalValue")			return kSource_GlobalValue;
+		if (sourceType.compare(0, 13, "PropertyValue") == 0)	return kSource_PropertyValue;
+		return kSource_None;
+	}
+
+	void ReadPageBindings(const Json::Value & content, PageBindings* page)
+	{
+		page->controlCount = 0;
+		if (!content.isArray()) return;
+
+		page->controlCount = content.size();
+		for (UInt32 i = 0; i < content.size(); i++) {
+			const Json::Value & control = content[i];
+			if (!control.isObject()) continue;
+
+			const Json::Value & valueOptions = control["valueOptions"];
+			if (!valueOptions.isObject()) continue;
+
+			ValueBinding binding;
+			binding.index		= i;
+			binding.sourceType	= GetSourceType(valueOptions.get("sourceType", "").asString());
+			if (binding.sourceType == kSource_None) continue;
+
+			binding.id				= control.get("id", "").asString();
+			binding.sourceForm		= valueOptions.get("sourceForm", "").asString();
+			binding.scriptName		= valueOptions.get("scriptName", "").asString();
+			binding.propertyName	= valueOptions.get("propertyName", "").asString();
+
+			page->bindings.push_back(binding);
+		}
+	}
+
+	std::shared_ptr<ModBindings> LoadModBindings(const std::string & filePath, const std::string & modName)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open()) return nullptr;
+
+		std::shared_ptr<ModBindings> bindings = std::make_shared<ModBindings>();
+		ModBindings & mod = *bindings;
+		try {
+			// The document is only needed while the bindings are extracted, so allocate it from an arena
+			// and release it in one go rather than node by node.
+			Json::ValueArena arena;
+			Json::ScopedValueArena arenaScope(arena);
+			Json::Value root;
+			Json::Reader reader;
+			if (!reader.parse(file, root, false) || !root.isObject()) {
+				MCM_LOG_WARNING("Warning: Failed to parse config.json for mod %s.", modName.c_str());
+				return nullptr;
+			}
+
+			const Json::Value & json = root;	// Const access avoids inserting nulls for missing keys.
+			mod.modName		= json.get("modName", modName).asString();
+
+			ReadPageBindings(json["content"], &mod.rootPage);
+
+			const Json::Value & pages = json["pages"];
+			if (pages.isArray()) {
+				for (UInt32 i = 0; i < pages.size(); i++) {
+					PageBindings page;
+					page.pageName = pages[i].get("pageDisplayName", "").asString();
+					ReadPageBindings(pages[i]["content"], &page);
+					mod.pages.push_back(page);
+				}
+			}
+		} catch (...) {
+			MCM_LOG_WARNING("Warning: Failed to parse malformed config.json for mod %s.", modName.c_str());
+			return nullptr;
+		}
+
+		return bindings;
+	}
+
+	// Returns the bindings for a mod, (re)parsing config.json if it has changed on disk.
+	std::shared_ptr<const ModBindings> GetModBindings(const std::string & modName)
+	{
+		MCMContentIndex::ModContent content;
+		if (!MCMContentIndex::GetInstance().GetMod(modName, &content) || !(content.flags & MCMContentIndex::kContent_Config)) {
+			return nullptr;
+		}
+
+		std::string filePath = "Data\\MCM\\Config\\" + content.name + "\\config.json";
+		return MCMDocumentCache::GetInstance().Get<ModBindings>(filePath, content.configStamp, [&modName](const std::string & path) {
+			return LoadModBindings(path, modName);
+		});
+	}
+
+	const PageBindings* FindPage(const ModBindings* mod, const GFxValue* pageId)
+	{
+		switch (pageId->GetType()) {
+			case GFxValue::kType_Int:
+			case GFxValue::kType_UInt:
+			case GFxValue::kType_Number:
+			{
+				SInt32 idx = (pageId->GetType() == GFxValue::kType_Number) ? (SInt32)pageId->GetNumber() : pageId->GetInt();
+				if (idx < 0) return &mod->rootPage;
+				if (idx < mod->pages.size()) return &mod->pages[idx];
+				return nullptr;
+			}
+			case GFxValue::kType_String:
+			{
+				const char* pageName = pageId->GetString();
+				for (auto & page : mod->pages) {
+					if (page.pageName == pageName) return &page;
+				}
+				return nullptr;
+			}
+			default:
+				return &mod->rootPage;
+		}
+	}
+
+	void ResolveModSettings(GFxMovieRoot* movieRoot, const std::string & modName, std::vector<const ValueBinding*> & bindings, std::vector<GFxValue> & values)
+	{
+		SettingStore& store = SettingStore::GetInstance();
+		for (auto binding : bindings) {
+			GFxValue & value = values[binding->index];
+			switch (binding->sourceType) {
+				case kSource_ModSettingBool:	value.SetBool(store.GetModSettingBool(modName, binding->id));		break;
+				case kSource_ModSettingInt:		value.SetInt(store.GetModSettingInt(modName, binding->id));			break;
+				case kSource_ModSettingFloat:	value.SetNumber(store.GetModSettingFloat(modName, binding->id));	break;
+				case kSource_ModSettingString:
+				{
+					Setting* ms = store.GetModSetting(modName, binding->id);
+					if (ms) movieRoot->CreateString(&value, store.GetModSettingString(ms).c_str());
+					break;
+				}
+			}
+		}
+	}
+
+	void ResolveGlobals(std::vector<const ValueBinding*> & bindings, std::vector<GFxValue> & values)
+	{
+		for (auto binding : bindings) {
+			TESGlobal* global = MCMUtils::GetGlobalFromIdentifier(binding->sourceForm);
+			if (global) {
+				values[binding->index].SetNumber(global->value);
+			}
+		}
+	}
+
+	// All bindings must share the same sourceForm and scriptName. The script object is resolved once for the group.
+	void ResolveProperties(GFxMovieRoot* movieRoot, std::vector<const ValueBinding*> & bindings, std::vector<GFxValue> & values)
+	{
+		const ValueBinding* first = bindings.front();
+		TESForm* form = MCMUtils::GetFormFromIdentifier(first->sourceForm);
+		if (!form) {
+			MCM_LOG_WARNING("Warning: Cannot retrieve property values from a None form. (%s)", first->sourceForm.c_str());
+			return;
+		}
+
+		VirtualMachine* vm = (*G::gameVM)->m_virtualMachine;
+		MCMUtils::VMScript script(form, first->scriptName.c_str());
+		if (!script.m_identifier) {
+			MCM_LOG_WARNING("Warning: Cannot retrieve property values from a form with no scripts attached. (%s)", first->sourceForm.c_str());
+			return;
+		}
+
+		for (auto binding : bindings) {
+			MCMUtils::PropertyInfo pInfo = {};
+			pInfo.index = -1;
+			BSFixedString propertyName(binding->propertyName.c_str());
+			MCMUtils::GetPropertyInfo(script.m_identifier->m_typeInfo, &pInfo, &propertyName);
+
+			if (pInfo.index != -1) {
+				VMValue valueOut;
+				vm->GetPropertyValueByIndex(&script.m_identifier, pInfo.index, &valueOut);
+				PlatformAdapter::ConvertPapyrusValue(&values[binding->index], &valueOut, movieRoot);
+			} else {
+				MCM_LOG_WARNING("Warning: Property %s does not exist on script %s", binding->propertyName.c_str(), script.m_identifier->m_typeInfo->m_typeName.c_str());
+			}
+		}
+	}
+
+	void ResolvePageValues(GFxMovieRoot* movieRoot, const char* modName, const GFxValue* pageId, GFxValue* result)
+	{
+		movieRoot->CreateArray(result);
+
+		std::shared_ptr<const ModBindings> mod = GetModBindings(modName);
+		if (!mod) return;
+
+		const PageBindings* page = FindPage(mod.get(), pageId);
+		if (!page) return;
+
+		std::vector<GFxValue> values(page->controlCount);
+		for (auto & value : values) value.SetNull();
+
+		// Group bindings by source.
+		std::vector<const ValueBinding*> modSettings, globals;
+		std::map<std::pair<std::string, std::string>, std::vector<const ValueBinding*>> properties;	// (sourceForm, scriptName) -> bindings
+
+		for (auto & binding : page->bindings) {
+			switch (binding.sourceType) {
+				case kSource_GlobalValue:
+					globals.push_back(&binding);
+					break;
+				case kSource_PropertyValue:
+					properties[std::make_pair(binding.sourceForm, binding.scriptName)].push_back(&binding);
+					break;
+				default:
+					modSettings.push_back(&binding);
+					break;
+			}
+		}
+
+		if (!modSettings.empty())	ResolveModSettings(movieRoot, mod->modName, modSettings, values);
+		if (!globals.empty())		ResolveGlobals(globals, values);
+		for (auto & group : properties) {
+			ResolveProperties(movieRoot, group.second, values);
+		}
+
+		for (auto & value : values) {
+			result->PushBack(&value);
+		}
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+class GFxMovieRoot;
+class GFxValue;
+
+// Resolves the values of every control on a config.json page in a single native call.
+// Control bindings are parsed from config.json once per file version and grouped by value source,
+// so that ModSetting, GlobalValue and PropertyValue lookups can be batched.
+namespace MCMPageValues
+{
+	// pageId is either a page index (-1 for the mod's root content) or a pageDisplayName string.
+	// result is set to an array aligned with the page's content array. Controls without a value source, or whose value
+	// could not be resolved, are null.
+	void ResolvePageValues(GFxMovieRoot* movieRoot, const char* modName, const GFxValue* pageId, GFxValue* result);
+}
@@ -0,0 +1,158 @@
+#include "MCMPluginAPI.h"
+
+#include <mutex>
+#include <vector>
+
+#include "f4se/GameSettings.h"
+
+#include "MCMAPI.h"
+#include "MCMKeybinds.h"
+#include "MCMStringPool.h"
+#include "SettingStore.h"
+#include "MCMLog.h"
+
+namespace MCMPluginAPI
+{
+	namespace
+	{
+		struct Listener
+		{
+			UInt32							id;
+			MCMStringPool::StringID			modName;	// kInvalidID = every mod.
+			MCMAPI::SettingChangedCallback	callback;
+			void*							userData;
+		};
+
+		std::mutex				s_listenerLock;
+		std::vector<Listener>	s_listeners;
+		UInt32					s_nextListenerID = 1;
+
+		Setting* ToSetting(MCMAPI::SettingHandle setting)
+		{
+			return reinterpret_cast<Setting*>(setting);
+		}
+
+		MCMAPI::SettingHandle GetSetting(const char* modName, const char* settingName)
+		{
+			if (!modName || !settingName) return nullptr;
+			return reinterpret_cast<MCMAPI::SettingHandle>(SettingStore::GetInstance().GetModSetting(modName, settingName));
+		}
+
+		MCMAPI::SettingType GetSettingType(MCMAPI::SettingHandle setting)
+		{
+			if (!setting) return MCMAPI::kSettingType_None;
+			switch (ToSetting(setting)->GetType()) {
+				case Setting::kType_Bool:		return MCMAPI::kSettingType_Bool;
+				case Setting::kType_Integer:	return MCMAPI::kSettingType_Int;
+				case Setting::kType_Float:		return MCMAPI::kSettingType_Float;
+				case Setting::kType_String:		return MCMAPI::kSettingType_String;
+				default:						return MCMAPI::kSettingType_None;
+			}
+		}
+
+		// Numeric values are single aligned 32-bit words, so plain reads never observe a partially written value.
+		bool GetBool(MCMAPI::SettingHandle setting)
+		{
+			return setting && ToSetting(setting)->data.u8 > 0;
+		}
+
+		SInt32 GetInt(MCMAPI::SettingHandle setting)
+		{
+			return setting ? ToSetting(setting)->data.s32 : -1;
+		}
+
+		float GetFloat(MCMAPI::SettingHandle setting)
+		{
+			return setting ? ToSetting(setting)->data.f32 : -1;
+		}
+
+		UInt32 GetString(MCMAPI::SettingHandle setting, char* buffer, UInt32 bufferSize)
+		{
+			if (!setting || GetSettingType(setting) != MCMAPI::kSettingType_String) {
+				if (buffer && bufferSize) buffer[0] = '\0';
+				return 0;
+			}
+			return SettingStore::GetInstance().CopyModSettingString(ToSetting(setting), buffer, bufferSize);
+		}
+
+		UInt32 AddSettingListener(const char* modName, MCMAPI::SettingChangedCallback callback, void* userData)
+		{
+			if (!callback) return 0;
+
+			Listener listener;
+			listener.modName	= modName ? MCMStringPool::GetInstance().Intern(modName) : (MCMStringPool::StringID)MCMStringPool::kInvalidID;
+			listener.callback	= callback;
+			listener.userData	= userData;
+
+			std::lock_guard<std::mutex> lock(s_listenerLock);
+			listener.id = s_nextListenerID++;
+			s_listeners.push_back(listener);
+			return listener.id;
+		}
+
+		void RemoveSettingListener(UInt32 listenerID)
+		{
+			std::lock_guard<std::mutex> lock(s_listenerLock);
+			for (auto itr = s_listeners.begin(); itr != s_listeners.end(); ++itr) {
+				if (itr->id == listenerID) {
+					s_listeners.erase(itr);
+					return;
+				}
+			}
+		}
+
+		bool GetKeybind(const char* modName, const char* keybindID, UInt32* keycode, UInt8* modifiers)
+		{
+			if (!modName || !keybindID) return false;
+
+			Keybind kb;
+			if (!g_keybindManager.FindKeybind(modName, keybindID, &kb)) return false;
+
+			if (keycode)	*keycode = kb.keycode;
+			if (modifiers)	*modifiers = kb.modifiers;
+			return true;
+		}
+
+		MCMAPI::Interface s_interface = {
+			MCMAPI::kInterfaceVersion,
+			sizeof(MCMAPI::Interface),
+			GetSetting,
+			GetSettingType,
+			GetBool,
+			GetInt,
+			GetFloat,
+			GetString,
+			AddSettingListener,
+			RemoveSettingListener,
+			GetKeybind,
+		};
+	}
+
+	void Publish(F4SEMessagingInterface* messaging, PluginHandle pluginHandle)
+	{
+		MCMAPI::Interface* iface = &s_interface;
+		messaging->Dispatch(pluginHandle, MCMAPI::kMessage_Interface, &iface, sizeof(iface), nullptr);
+		MCM_LOG_MESSAGE("Published plugin interface v%d.", MCMAPI::kInterfaceVersion);
+	}
+
+	void NotifySettingChanged(const std::string & modName, const char* settingName)
+	{
+		std::vector<Listener> listeners;
+		{
+			std::lock_guard<std::mutex> lock(s_listenerLock);
+			if (s_listeners.empty()) return;
+
+			MCMStringPool::StringID modID = MCMStringPool::GetInstance().Find(modName);
+			for (auto & listener : s_listeners) {
+				if (listener.modName == MCMStringPool::kInvalidID || listener.modName == modID) {
+					listeners.push_back(listener);
+				}
+			}
+		}
+
+		// Called without the lock held, so callbacks may add or remove listeners.
+		for (auto & listener : listeners) {
+			listener.callback(modName.c_str(), settingName, listener.userData);
+		}
+	}
+}
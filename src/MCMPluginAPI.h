@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "f4se/PluginAPI.h"
+
+// Implements the MCMAPI interface (MCMAPI.h) published to other F4SE plugins.
+namespace MCMPluginAPI
+{
+	// Dispatches the interface to every plugin listening to the MCM. Call once all plugins have loaded.
+	void Publish(F4SEMessagingInterface* messaging, PluginHandle pluginHandle);
+
+	// Invokes the listeners registered for a mod. Called by SettingStore after a setting has changed.
+	void NotifySettingChanged(const std::string & modName, const char* settingName);
+}
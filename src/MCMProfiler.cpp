@@ -0,0 +1,418 @@
+#include "MCMProfiler.h"
+#include "MCMLog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <intrin.h>
+
+//-------------------------
+// Allocation Counting
+//-------------------------
+
+namespace
+{
+	thread_local MCMProfiler::Subsystem		t_allocationTag = MCMProfiler::kSubsystem_Other;
+}
+
+// The global allocator is only replaced in memory profiling builds, so release builds keep the CRT's.
+#ifdef MCM_MEMORY_PROFILING
+
+namespace
+{
+	enum { kMaxMemoryThreads = 128 };
+
+	thread_local UInt64		t_allocations = 0;
+
+	// Memory counters for a single thread, by subsystem. Each block is only written by its owning thread, so
+	// allocations never contend; readers sum across blocks. Frees are counted by the freeing thread against the
+	// allocating subsystem, so one block's live bytes may be negative, but the sum across blocks is not.
+	// Threads beyond kMaxMemoryThreads share the last block and update it atomically.
+	// Zero-initialized before any dynamic initialization, so allocations made by static constructors are counted.
+	struct ThreadMemoryCounters
+	{
+		std::atomic<SInt64>	liveBytes[MCMProfiler::kSubsystem_Count];
+		std::atomic<UInt64>	allocations[MCMProfiler::kSubsystem_Count];
+		std::atomic<UInt64>	frees[MCMProfiler::kSubsystem_Count];
+	};
+	ThreadMemoryCounters	s_memoryThreads[kMaxMemoryThreads];
+	std::atomic<UInt32>		s_memoryThreadCount;
+	std::atomic<UInt64>		s_peakBytes[MCMProfiler::kSubsystem_Count];	// Highest live total seen by GetMemoryUsage.
+
+	thread_local ThreadMemoryCounters*	t_memoryCounters = nullptr;
+	thread_local bool					t_sharedMemoryCounters = false;
+
+	ThreadMemoryCounters* GetMemoryCounters(bool* shared)
+	{
+		if (!t_memoryCounters) {
+			UInt32 index = s_memoryThreadCount.fetch_add(1, std::memory_order_relaxed);
+			t_sharedMemoryCounters	= index >= kMaxMemoryThreads - 1;
+			t_memoryCounters		= &s_memoryThreads[t_sharedMemoryCounters ? kMaxMemoryThreads - 1 : index];
+		}
+		*shared = t_sharedMemoryCounters;
+		return t_memoryCounters;
+	}
+
+	template <typename T>
+	void AddCounter(std::atomic<T> & counter, T value, bool shared)
+	{
+		if (shared) {
+			counter.fetch_add(value, std::memory_order_relaxed);
+		} else {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+	}
+
+	// Prepended to every allocation so that frees can be credited to the right subsystem. 16 bytes keeps the
+	// alignment malloc guarantees.
+	struct AllocationHeader
+	{
+		UInt64	size;
+		UInt32	subsystem;
+		UInt32	reserved;
+	};
+	static_assert(sizeof(AllocationHeader) == 16, "AllocationHeader must preserve 16-byte alignment");
+}
+
+void* operator new(size_t size)
+{
+	t_allocations++;
+	AllocationHeader* header = (AllocationHeader*)malloc(sizeof(AllocationHeader) + size);
+	if (!header) throw std::bad_alloc();
+
+	header->size = size;
+	header->subsystem = t_allocationTag;
+
+	bool shared;
+	ThreadMemoryCounters* counters = GetMemoryCounters(&shared);
+	AddCounter(counters->allocations[header->subsystem], (UInt64)1, shared);
+	AddCounter(counters->liveBytes[header->subsystem], (SInt64)size, shared);
+
+	return header + 1;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	if (!p) return;
+
+	AllocationHeader* header = (AllocationHeader*)p - 1;
+
+	bool shared;
+	ThreadMemoryCounters* counters = GetMemoryCounters(&shared);
+	AddCounter(counters->frees[header->subsystem], (UInt64)1, shared);
+	AddCounter(counters->liveBytes[header->subsystem], -(SInt64)header->size, shared);
+
+	free(header);
+}
+
+void operator delete[](void* p) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+#endif
+
+//-------------------------
+// Counters
+//-------------------------
+
+namespace MCMProfiler
+{
+	// Counters for a single thread. Each block is only written by its owning thread; readers sum across blocks.
+	struct ThreadCounters
+	{
+		std::atomic<UInt64>	calls[kMaxNatives];
+		std::atomic<UInt64>	ticks[kMaxNatives];
+		std::atomic<UInt64>	allocations[kMaxNatives];
+		std::atomic<UInt32>	histogram[kMaxNatives][kHistogramBuckets];
+
+		ThreadCounters()
+		{
+			for (UInt32 i = 0; i < kMaxNatives; i++) {
+				calls[i] = 0;
+				ticks[i] = 0;
+				allocations[i] = 0;
+				for (UInt32 j = 0; j < kHistogramBuckets; j++) histogram[i][j] = 0;
+			}
+		}
+	};
+
+	std::mutex									s_lock;
+	std::vector<std::string>					s_names;
+	std::vector<std::unique_ptr<ThreadCounters>>	s_threads;	// Never shrinks, so counters from finished threads are kept.
+
+	thread_local ThreadCounters*				t_counters = nullptr;
+
+	UInt64 GetFrequency()
+	{
+		static UInt64 frequency = 0;
+		if (!frequency) {
+			LARGE_INTEGER li;
+			QueryPerformanceFrequency(&li);
+			frequency = li.QuadPart;
+		}
+		return frequency;
+	}
+
+	UInt64 TicksToNanoseconds(UInt64 ticks)
+	{
+		UInt64 frequency = GetFrequency();
+		return (ticks / frequency) * 1000000000ULL + ((ticks % frequency) * 1000000000ULL) / frequency;
+	}
+
+	UInt32 GetBucket(UInt64 ns)
+	{
+		if (ns < 4) return (UInt32)ns;
+
+		unsigned long octave;
+		_BitScanReverse64(&octave, ns);
+		UInt32 sub = (ns >> (octave - 2)) & 3;
+		UInt32 bucket = 4 + (octave - 2) * 4 + sub;
+		return std::min<UInt32>(bucket, kHistogramBuckets - 1);
+	}
+
+	// Returns the upper bound of a bucket, in nanoseconds.
+	UInt64 GetBucketLimit(UInt32 bucket)
+	{
+		if (bucket < 4) return bucket + 1;
+
+		UInt32 octave = (bucket - 4) / 4 + 2;
+		UInt32 sub = (bucket - 4) % 4;
+		return (UInt64)(4 + sub + 1) << (octave - 2);
+	}
+
+	UInt64 GetPercentile(const UInt64* histogram, UInt64 total, double percentile)
+	{
+		UInt64 target = (UInt64)(total * percentile);
+		UInt64 seen = 0;
+		for (UInt32 i = 0; i < kHistogramBuckets; i++) {
+			seen += histogram[i];
+			if (seen > target) return GetBucketLimit(i);
+		}
+		return GetBucketLimit(kHistogramBuckets - 1);
+	}
+
+	ThreadCounters* GetThreadCounters()
+	{
+		if (!t_counters) {
+			std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+			t_counters = counters.get();
+
+			std::lock_guard<std::mutex> lock(s_lock);
+			s_threads.push_back(std::move(counters));
+		}
+		return t_counters;
+	}
+
+	UInt32 RegisterNative(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+		for (UInt32 i = 0; i < s_names.size(); i++) {
+			if (s_names[i] == name) return i;
+		}
+
+		if (s_names.size() >= kMaxNatives) {
+			MCM_LOG_WARNING("Warning: Too many natives to profile. %s will share the last slot.", name);
+			return kMaxNatives - 1;
+		}
+
+		s_names.push_back(name);
+		return s_names.size() - 1;
+	}
+
+	void RecordCall(UInt32 id, UInt64 elapsedTicks, UInt64 allocations)
+	{
+		ThreadCounters* counters = GetThreadCounters();
+
+		// Single writer per block: plain load/store is enough, readers only need a consistent value per counter.
+		counters->calls[id].store(counters->calls[id].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		counters->ticks[id].store(counters->ticks[id].load(std::memory_order_relaxed) + elapsedTicks, std::memory_order_relaxed);
+		counters->allocations[id].store(counters->allocations[id].load(std::memory_order_relaxed) + allocations, std::memory_order_relaxed);
+
+		std::atomic<UInt32> & bucket = counters->histogram[id][GetBucket(TicksToNanoseconds(elapsedTicks))];
+		bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	UInt64 GetThreadAllocationCount()
+	{
+#ifdef MCM_MEMORY_PROFILING
+		return t_allocations;
+#else
+		return 0;
+#endif
+	}
+
+	UInt64 GetTicks()
+	{
+		LARGE_INTEGER li;
+		QueryPerformanceCounter(&li);
+		return li.QuadPart;
+	}
+
+	struct NativeSummary
+	{
+		std::string	name;
+		UInt64		calls;
+		UInt64		ticks;
+		UInt64		allocations;
+		UInt64		p50;	// ns
+		UInt64		p99;	// ns
+	};
+
+	void DumpProfile()
+	{
+		std::vector<NativeSummary> summaries;
+
+		{
+			std::lock_guard<std::mutex> lock(s_lock);
+			for (UInt32 id = 0; id < s_names.size(); id++) {
+				NativeSummary summary = {};
+				summary.name = s_names[id];
+
+				std::vector<UInt64> histogram(kHistogramBuckets, 0);
+				for (auto & counters : s_threads) {
+					summary.calls		+= counters->calls[id].load(std::memory_order_relaxed);
+					summary.ticks		+= counters->ticks[id].load(std::memory_order_relaxed);
+					summary.allocations	+= counters->allocations[id].load(std::memory_order_relaxed);
+					for (UInt32 i = 0; i < kHistogramBuckets; i++) {
+						histogram[i] += counters->histogram[id][i].load(std::memory_order_relaxed);
+					}
+				}
+
+				if (summary.calls == 0) continue;
+				summary.p50 = GetPercentile(histogram.data(), summary.calls, 0.50);
+				summary.p99 = GetPercentile(histogram.data(), summary.calls, 0.99);
+				summaries.push_back(summary);
+			}
+		}
+
+		std::sort(summaries.begin(), summaries.end(), [](const NativeSummary & a, const NativeSummary & b) {
+			return a.ticks > b.ticks;
+		});
+
+		MCM_LOG_MESSAGE("MCM native profile (%d natives called):", summaries.size());
+#ifdef MCM_MEMORY_PROFILING
+		MCM_LOG_MESSAGE("%-32s %10s %12s %10s %10s %10s %10s", "Native", "Calls", "Total (us)", "Mean (us)", "p50 (us)", "p99 (us)", "Allocs");
+#else
+		// Allocations are only counted in memory profiling builds.
+		MCM_LOG_MESSAGE("%-32s %10s %12s %10s %10s %10s", "Native", "Calls", "Total (us)", "Mean (us)", "p50 (us)", "p99 (us)");
+#endif
+		for (auto & summary : summaries) {
+			UInt64 totalUs = TicksToNanoseconds(summary.ticks) / 1000;
+#ifdef MCM_MEMORY_PROFILING
+			MCM_LOG_MESSAGE("%-32s %10llu %12llu %10.1f %10.1f %10.1f %10llu",
+				summary.name.c_str(),
+				summary.calls,
+				totalUs,
+				(double)totalUs / summary.calls,
+				summary.p50 / 1000.0,
+				summary.p99 / 1000.0,
+				summary.allocations
+			);
+#else
+			MCM_LOG_MESSAGE("%-32s %10llu %12llu %10.1f %10.1f %10.1f",
+				summary.name.c_str(),
+				summary.calls,
+				totalUs,
+				(double)totalUs / summary.calls,
+				summary.p50 / 1000.0,
+				summary.p99 / 1000.0
+			);
+#endif
+		}
+	}
+
+	//-------------------------
+	// Memory Accounting
+	//-------------------------
+
+	const char* GetSubsystemName(Subsystem subsystem)
+	{
+		switch (subsystem) {
+			case kSubsystem_Settings:		return "Settings";
+			case kSubsystem_Keybinds:		return "Keybinds";
+			case kSubsystem_Translations:	return "Translations";
+			case kSubsystem_DocumentCache:	return "DocumentCache";
+			default:						return "Other";
+		}
+	}
+
+	Subsystem GetSubsystemByName(const char* name)
+	{
+		for (UInt32 i = 0; i < kSubsystem_Count; i++) {
+			if (_stricmp(name, GetSubsystemName((Subsystem)i)) == 0) return (Subsystem)i;
+		}
+		return kSubsystem_Count;
+	}
+
+	MemoryUsage GetMemoryUsage(Subsystem subsystem)
+	{
+		MemoryUsage usage = {};
+
+#ifdef MCM_MEMORY_PROFILING
+		SInt64 liveBytes = 0;
+		UInt32 threadCount = std::min<UInt32>(s_memoryThreadCount.load(std::memory_order_relaxed), kMaxMemoryThreads);
+		for (UInt32 i = 0; i < threadCount; i++) {
+			ThreadMemoryCounters & counters = s_memoryThreads[i];
+			liveBytes			+= counters.liveBytes[subsystem].load(std::memory_order_relaxed);
+			usage.allocations	+= counters.allocations[subsystem].load(std::memory_order_relaxed);
+			usage.frees			+= counters.frees[subsystem].load(std::memory_order_relaxed);
+		}
+		usage.liveBytes = liveBytes > 0 ? liveBytes : 0;
+
+		UInt64 peak = s_peakBytes[subsystem].load(std::memory_order_relaxed);
+		while (usage.liveBytes > peak && !s_peakBytes[subsystem].compare_exchange_weak(peak, usage.liveBytes, std::memory_order_relaxed)) {}
+		usage.peakBytes = std::max(peak, usage.liveBytes);
+#endif
+
+		return usage;
+	}
+
+	void DumpMemoryUsage()
+	{
+#ifndef MCM_MEMORY_PROFILING
+		MCM_LOG_MESSAGE("MCM memory usage is not available. Build with MCM_MEMORY_PROFILING to enable it.");
+#else
+		MCM_LOG_MESSAGE("MCM memory usage:");
+		MCM_LOG_MESSAGE("%-16s %12s %12s %12s %12s", "Subsystem", "Live (KB)", "Peak (KB)", "Allocs", "Frees");
+		for (UInt32 i = 0; i < kSubsystem_Count; i++) {
+			MemoryUsage usage = GetMemoryUsage((Subsystem)i);
+			MCM_LOG_MESSAGE("%-16s %12.1f %12.1f %12llu %12llu",
+				GetSubsystemName((Subsystem)i),
+				usage.liveBytes / 1024.0,
+				usage.peakBytes / 1024.0,
+				usage.allocations,
+				usage.frees
+			);
+		}
+#endif
+	}
+
+	Subsystem SetAllocationTag(Subsystem subsystem)
+	{
+		Subsystem previous = t_allocationTag;
+		t_allocationTag = subsystem;
+		return previous;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+struct StaticFunctionTag;
+
+// Call profiler for MCM natives.
+// Every Scaleform and Papyrus native registered by the MCM is wrapped so that its call count, cumulative time and
+// latency distribution are recorded. Counters are kept per thread and only written by the owning thread, so
+// recording a call never takes a lock.
+//
+// If MCM_MEMORY_PROFILING is defined (Debug builds), the global operator new and delete are replaced so that heap
+// allocations are also counted per native and accounted per subsystem. Allocations are charged to the subsystem
+// tagged on the allocating thread (see ScopedAllocationTag) and credited back to the same subsystem when freed, on
+// whichever thread. Counters are kept per thread and summed when read, so peakBytes is the highest live total seen
+// by a read rather than the true peak. Otherwise, the allocator is left alone and no allocations are counted.
+namespace MCMProfiler
+{
+	enum { kMaxNatives = 96 };
+
+	enum Subsystem {
+		kSubsystem_Other,
+		kSubsystem_Settings,		// SettingStore
+		kSubsystem_Keybinds,		// KeybindManager registrations and keybind definitions
+		kSubsystem_Translations,	// Translation loading
+		kSubsystem_DocumentCache,	// Parsed files held by MCMDocumentCache
+		kSubsystem_Count
+	};
+
+	struct MemoryUsage
+	{
+		UInt64	liveBytes;
+		UInt64	peakBytes;
+		UInt64	allocations;
+		UInt64	frees;
+	};
+
+	// Returns a stable ID for a native. Registering the same name again returns the existing ID.
+	UInt32 RegisterNative(const char* name);
+
+	// Records one call. Called by ScopedCall.
+	void RecordCall(UInt32 id, UInt64 elapsedTicks, UInt64 allocations);
+
+	// Number of heap allocations made by the current thread so far. Always 0 without MCM_MEMORY_PROFILING.
+	UInt64 GetThreadAllocationCount();
+
+	// Clock and latency histogram, shared with MCMTelemetry.
+	// The histogram has 4 linear buckets for 0-3 ns, then 4 sub-buckets per power of two up to ~2 hours.
+	enum { kHistogramBuckets = 168 };
+
+	UInt64 GetTicks();
+	UInt64 TicksToNanoseconds(UInt64 ticks);
+
+	UInt32 GetBucket(UInt64 ns);
+
+	// Returns the upper bound, in nanoseconds, of the bucket holding the given percentile (0-1) of total samples.
+	// histogram must have kHistogramBuckets entries.
+	UInt64 GetPercentile(const UInt64* histogram, UInt64 total, double percentile);
+
+	// Writes a summary of all natives that have been called to the log.
+	void DumpProfile();
+
+	const char* GetSubsystemName(Subsystem subsystem);
+	Subsystem GetSubsystemByName(const char* name);		// Case-insensitive. Returns kSubsystem_Count if unknown.
+
+	MemoryUsage GetMemoryUsage(Subsystem subsystem);
+
+	// Writes live bytes, peak and allocation counts for every subsystem to the log.
+	void DumpMemoryUsage();
+
+	Subsystem SetAllocationTag(Subsystem subsystem);	// Returns the previous tag.
+
+	// Charges heap allocations made by the current thread to a subsystem for the lifetime of the object.
+	class ScopedAllocationTag
+	{
+	public:
+		explicit ScopedAllocationTag(Subsystem subsystem) : m_previous(SetAllocationTag(subsystem)) {}
+		~ScopedAllocationTag() { SetAllocationTag(m_previous); }
+
+		ScopedAllocationTag(ScopedAllocationTag const&)	= delete;
+		void operator=(ScopedAllocationTag const&)		= delete;
+
+	private:
+		Subsystem	m_previous;
+	};
+
+	class ScopedCall
+	{
+	public:
+		explicit ScopedCall(UInt32 id) : m_id(id), m_allocations(GetThreadAllocationCount()), m_start(GetTicks()) {}
+		~ScopedCall()
+		{
+			UInt64 elapsed = GetTicks() - m_start;
+			RecordCall(m_id, elapsed, GetThreadAllocationCount() - m_allocations);
+		}
+
+	private:
+		UInt32	m_id;
+		UInt64	m_allocations;
+		UInt64	m_start;
+	};
+
+	// Wraps a Papyrus native function pointer. Use MCM_PROFILED_NATIVE rather than naming this directly.
+	template <typename F, F fn>
+	struct ProfiledNative;
+
+	template <typename R, typename... Args, R (*fn)(StaticFunctionTag*, Args...)>
+	struct ProfiledNative<R (*)(StaticFunctionTag*, Args...), fn>
+	{
+		static UInt32 s_id;
+
+		static R Call(StaticFunctionTag* base, Args... args)
+		{
+			ScopedCall call(s_id);
+			return fn(base, args...);
+		}
+
+		static R (*Bind(const char* name))(StaticFunctionTag*, Args...)
+		{
+			s_id = RegisterNative(name);
+			return &Call;
+		}
+	};
+
+	template <typename R, typename... Args, R (*fn)(StaticFunctionTag*, Args...)>
+	UInt32 ProfiledNative<R (*)(StaticFunctionTag*, Args...), fn>::s_id = 0;
+}
+
+// Evaluates to a function pointer that records calls to fn under the given name before forwarding to it.
+#define MCM_PROFILED_NATIVE(name, fn) MCMProfiler::ProfiledNative<decltype(&fn), &fn>::Bind(name)
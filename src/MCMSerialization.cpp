@@ -4,6 +4,10 @@
 
 #include "MCMSerialization.h"
 #include "MCMKeybinds.h"
+#include "MCMFormLists.h"
+#include "MCMTelemetry.h"
+#include "MCMProfiler.h"
+#include "MCMLog.h"
 
 const char* KEYBIND_LOCATION = "Data\\MCM\\Settings\\Keybinds.json";
 
@@ -17,36 +21,40 @@ namespace MCMSerialization
 
 	void RevertCallback(const F4SESerializationInterface * intfc)
 	{
-		_DMESSAGE("Clearing MCM co-save internal state.");
+		MCM_LOG_DEBUG("Clearing MCM co-save internal state.");
 		g_keybindManager.Clear();
+		MCMFormLists::Clear();
 	}
 
 	void LoadCallback(const F4SESerializationInterface * intfc)
 	{
-		_DMESSAGE("Loading MCM data.");
+		MCM_LOG_DEBUG("Loading MCM data.");
 
-		LARGE_INTEGER countStart, countEnd, frequency;
-		QueryPerformanceCounter(&countStart);
-		QueryPerformanceFrequency(&frequency);
+		MCMTelemetry::ScopedSpan span("MCMSerialization::LoadCallback");
 
 		// Load keybind registrations.
-		std::ifstream file(KEYBIND_LOCATION);
-		std::stringstream ss;
-		if (file.is_open()) {
-			ss << file.rdbuf();
-			file.close();
-			g_keybindManager.FromJSON(ss.str());
-		} else {
-			_MESSAGE("Keybind storage could not be opened or does not exist.");
-		}
-
-		QueryPerformanceCounter(&countEnd);
-		_MESSAGE("Elapsed: %llu ms.", (countEnd.QuadPart - countStart.QuadPart) / (frequency.QuadPart / 1000));
+		g_keybindManager.FromFile(KEYBIND_LOCATION);
+
+		MCM_LOG_MESSAGE("Elapsed: %.3f ms.", span.GetElapsed() / 1000.0);
+
+#ifdef MCM_MEMORY_PROFILING
+		// Keybind memory should return to the same level after every revert/load cycle.
+		MCMProfiler::MemoryUsage keybindMemory = MCMProfiler::GetMemoryUsage(MCMProfiler::kSubsystem_Keybinds);
+		MCM_LOG_MESSAGE("Keybind memory: %llu bytes live, %llu bytes peak.", keybindMemory.liveBytes, keybindMemory.peakBytes);
+#endif
 	}
 
 	void SaveCallback(const F4SESerializationInterface * intfc)
 	{
-		g_keybindManager.CommitKeybinds();
+		g_keybindManager.CommitKeybinds(MCMIOWorker::kPriority_SaveCritical);
+
+		// Make sure keybinds and settings are on disk by the time the save completes.
+		MCMIOWorker::GetInstance().Flush();
+	}
+
+	void Prefetch()
+	{
+		g_keybindManager.PrefetchKeybinds(KEYBIND_LOCATION);
 	}
 	
 }
\ No newline at end of file
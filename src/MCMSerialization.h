@@ -6,4 +6,7 @@ namespace MCMSerialization
 	void RevertCallback(const F4SESerializationInterface * intfc);
 	void LoadCallback(const F4SESerializationInterface * intfc);
 	void SaveCallback(const F4SESerializationInterface * intfc);
+
+	// Warms the caches used by LoadCallback in the background. Call once the game has loaded.
+	void Prefetch();
 }
\ No newline at end of file
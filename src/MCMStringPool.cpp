@@ -0,0 +1,51 @@
+#include "MCMStringPool.h"
+
+#include <ctype.h>
+
+size_t MCMStringPool::CaseInsensitiveHash::operator()(const char* str) const
+{
+	// FNV-1a over the lowercased string.
+	size_t hash = (size_t)14695981039346656037ULL;
+	for (const char* p = str; *p; p++) {
+		hash ^= (unsigned char)tolower((unsigned char)*p);
+		hash *= (size_t)1099511628211ULL;
+	}
+	return hash;
+}
+
+MCMStringPool::StringID MCMStringPool::Intern(const char* str)
+{
+	// Almost every string is already in the pool, so look it up without blocking other readers first.
+	StringID id = Find(str);
+	if (id != kInvalidID) return id;
+
+	std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+
+	// Another thread may have added it since the lookup.
+	auto itr = m_ids.find(str);
+	if (itr != m_ids.end()) return itr->second;
+
+	m_strings.push_back(str);
+	id = m_strings.size();
+	m_ids.insert(std::make_pair(m_strings.back().c_str(), id));
+	return id;
+}
+
+MCMStringPool::StringID MCMStringPool::Find(const char* str)
+{
+	std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+
+	auto itr = m_ids.find(str);
+	return itr != m_ids.end() ? itr->second : (StringID)kInvalidID;
+}
+
+UInt64 MCMStringPool::FindKey(const char* first, const char* second)
+{
+	std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+
+	auto firstItr = m_ids.find(first);
+	if (firstItr == m_ids.end()) return 0;
+	auto secondItr = m_ids.find(second);
+	if (secondItr == m_ids.end()) return 0;
+	return MakeKey(firstItr->second, secondItr->second);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Interned mod names, setting names and keybind IDs.
+// Each distinct string is stored once and identified by a small ID that stays valid for the lifetime of the process.
+// Strings are compared case-insensitively when they are interned, so indexes keyed on IDs match names the same way
+// the INI and JSON files they come from are matched, without lowercasing a copy on every lookup.
+// Lookups only take a shared lock, so they never wait on each other; interning a new string takes it exclusively.
+class MCMStringPool
+{
+public:
+	static MCMStringPool& GetInstance() {
+		static MCMStringPool instance;
+		return instance;
+	}
+
+	typedef UInt32 StringID;
+	enum { kInvalidID = 0 };
+
+	// Returns the ID of str, adding it to the pool if necessary.
+	StringID Intern(const char* str);
+	StringID Intern(const std::string & str) { return Intern(str.c_str()); }
+
+	// Returns the ID of str, or kInvalidID if it has never been interned. Never allocates.
+	StringID Find(const char* str);
+	StringID Find(const std::string & str) { return Find(str.c_str()); }
+
+	// Combines two IDs into a single key, e.g. for (mod, setting) pairs.
+	static UInt64 MakeKey(StringID first, StringID second) { return ((UInt64)first << 32) | second; }
+
+	// Looks up both strings under a single lock and returns their combined key, or 0 if either has never been interned.
+	UInt64 FindKey(const char* first, const char* second);
+	UInt64 FindKey(const std::string & first, const std::string & second) { return FindKey(first.c_str(), second.c_str()); }
+
+private:
+	MCMStringPool() {}
+
+	struct CaseInsensitiveHash
+	{
+		size_t operator()(const char* str) const;
+	};
+
+	struct CaseInsensitiveEqual
+	{
+		bool operator()(const char* lhs, const char* rhs) const { return _stricmp(lhs, rhs) == 0; }
+	};
+
+	typedef std::unordered_map<const char*, StringID, CaseInsensitiveHash, CaseInsensitiveEqual> IDMap;
+
+	std::shared_timed_mutex		m_lock;
+	std::deque<std::string>		m_strings;	// Index is ID - 1. Elements never move.
+	IDMap						m_ids;		// Keys point into m_strings.
+
+public:
+	MCMStringPool(MCMStringPool const&)		= delete;
+	void operator=(MCMStringPool const&)	= delete;
+};
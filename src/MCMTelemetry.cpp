@@ -0,0 +1,145 @@
+#include "MCMTelemetry.h"
+#include "MCMLog.h"
+#include "MCMProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace MCMTelemetry
+{
+	namespace
+	{
+		enum {
+			kMaxEvents			= 16384,	// Spans beyond this are only counted in the histograms.
+		};
+
+		struct Event
+		{
+			const char*	name;
+			UInt64		start;		// us
+			UInt64		duration;	// us
+			UInt32		thread;
+		};
+
+		struct SpanStats
+		{
+			UInt64	count;
+			UInt64	total;
+			UInt64	max;
+			UInt64	histogram[MCMProfiler::kHistogramBuckets];	// Nanosecond buckets.
+		};
+
+		std::mutex							s_lock;
+		std::vector<Event>					s_events;
+		std::map<std::string, SpanStats>	s_stats;
+		UInt32								s_droppedEvents = 0;
+		UInt32								s_threadCount = 0;
+
+		thread_local UInt32					t_thread = 0;	// 1-based trace thread ID, assigned on first use.
+
+		// Returns a percentile in microseconds. The bucket bound is clamped to the slowest span actually seen.
+		UInt64 GetPercentile(const SpanStats & stats, double percentile)
+		{
+			UInt64 limit = MCMProfiler::GetPercentile(stats.histogram, stats.count, percentile) / 1000;
+			return std::min(limit, stats.max);
+		}
+
+		void WriteJSONString(std::ofstream & file, const char* str)
+		{
+			file << '"';
+			for (const char* p = str; *p; p++) {
+				if (*p == '"' || *p == '\\') file << '\\';
+				file << *p;
+			}
+			file << '"';
+		}
+	}
+
+	UInt64 GetTime()
+	{
+		static const UInt64 start = MCMProfiler::GetTicks();
+		return MCMProfiler::TicksToNanoseconds(MCMProfiler::GetTicks() - start) / 1000;
+	}
+
+	void RecordSpan(const char* name, UInt64 start, UInt64 duration)
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+
+		if (!t_thread) t_thread = ++s_threadCount;
+
+		if (s_events.size() < kMaxEvents) {
+			Event event = { name, start, duration, t_thread };
+			s_events.push_back(event);
+		} else {
+			s_droppedEvents++;
+		}
+
+		auto itr = s_stats.find(name);
+		if (itr == s_stats.end()) {
+			SpanStats empty = {};
+			itr = s_stats.insert(std::make_pair(std::string(name), empty)).first;
+		}
+
+		SpanStats & stats = itr->second;
+		stats.count++;
+		stats.total += duration;
+		stats.max = std::max(stats.max, duration);
+		stats.histogram[MCMProfiler::GetBucket(duration * 1000)]++;
+	}
+
+	void DumpSummary()
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+
+		MCM_LOG_MESSAGE("MCM telemetry (%u spans, %u not traced):", (UInt32)s_events.size() + s_droppedEvents, s_droppedEvents);
+		MCM_LOG_MESSAGE("%-40s %8s %12s %10s %10s %10s %10s", "Span", "Count", "Total (us)", "Mean (us)", "p50 (us)", "p99 (us)", "Max (us)");
+		for (auto & entry : s_stats) {
+			const SpanStats & stats = entry.second;
+			MCM_LOG_MESSAGE("%-40s %8llu %12llu %10llu %10llu %10llu %10llu",
+				entry.first.c_str(),
+				stats.count,
+				stats.total,
+				stats.total / stats.count,
+				GetPercentile(stats, 0.50),
+				GetPercentile(stats, 0.99),
+				stats.max
+			);
+		}
+	}
+
+	bool ExportTrace(const std::string & path)
+	{
+		std::vector<Event> events;
+		UInt32 threadCount;
+		{
+			std::lock_guard<std::mutex> lock(s_lock);
+			events = s_events;
+			threadCount = s_threadCount;
+		}
+
+		// Trace Event Format: complete ("X") events with timestamps in microseconds.
+		std::ofstream file(path);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"MCM\"}}";
+		for (UInt32 i = 1; i <= threadCount; i++) {
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"Thread " << i << "\"}}";
+		}
+		for (auto & event : events) {
+			file << ",\n{\"name\":";
+			WriteJSONString(file, event.name);
+			file << ",\"cat\":\"mcm\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+				<< ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+		}
+		file << "]}\n";
+		file.close();
+
+		if (file.fail()) {
+			MCM_LOG_WARNING("Warning: Failed to write trace to %s.", path.c_str());
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+
+// Timing spans for coarse MCM phases: plugin load, settings and translation loads, game loads and menu sessions.
+// Each completed span is added to a per-name latency histogram and to the session's event list, which can be
+// exported as a Chrome trace (chrome://tracing, Perfetto) to see how the phases nest and overlap across threads.
+// Spans are meant for operations that take milliseconds; per-call timing of natives is done by MCMProfiler, whose
+// clock and histogram the spans share.
+namespace MCMTelemetry
+{
+	// Microseconds since the session started.
+	UInt64 GetTime();
+
+	// Records a completed span. Name must be a string literal or otherwise outlive the session.
+	void RecordSpan(const char* name, UInt64 start, UInt64 duration);
+
+	// Writes per-span statistics to the log.
+	void DumpSummary();
+
+	// Writes all spans recorded so far as Chrome trace JSON. Returns false if the file could not be written.
+	bool ExportTrace(const std::string & path);
+
+	// Times the enclosing scope. Spans opened inside it on the same thread are shown nested under it.
+	class ScopedSpan
+	{
+	public:
+		explicit ScopedSpan(const char* name) : m_name(name), m_start(GetTime()) {}
+		~ScopedSpan() { RecordSpan(m_name, m_start, GetTime() - m_start); }
+
+		ScopedSpan(ScopedSpan const&)		= delete;
+		void operator=(ScopedSpan const&)	= delete;
+
+		// Microseconds since the span was opened.
+		UInt64 GetElapsed() const { return GetTime() - m_start; }
+
+	private:
+		const char*	m_name;
+		UInt64		m_start;
+	};
+}
+
+#define MCM_TRACE_LOCATION "Data\\MCM\\Trace.json"
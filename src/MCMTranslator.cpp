@@ -2,87 +2,358 @@
 
 #include "common/IFileStream.h"
 #include <shlobj.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <unordered_map>
 #include <string>
+#include <thread>
+#include <emmintrin.h>
+#include <intrin.h>
 #include "f4se/GameStreams.h"
 #include "f4se/GameSettings.h"
 
 #include "f4se/ScaleformState.h"
 #include "f4se/ScaleformTranslator.h"
 
+#include "MCMContentIndex.h"
+#include "MCMTelemetry.h"
+#include "MCMProfiler.h"
+#include "MCMLog.h"
+
+#define MCM_TRANSLATION_CACHE_DIRECTORY "Data\\MCM\\Cache\\Translations"
+
 // This file is adapted from f4se/Translation.cpp.
 
 namespace MCMTranslator
 {
+	// The EN and locale-specific translations of one mod.
+	struct TranslationSet
+	{
+		std::string			modName;
+		std::vector<char>	baseData;		// EN file contents. Empty if not present.
+		std::vector<char>	localeData;		// Locale file contents. Empty if not present or if the locale is EN.
+		UInt64				sourceHash;
+		TranslationTable	table;			// Merged table.
+		bool				cached;			// table was loaded from the compiled cache.
+		bool				valid;
+		bool				writeFailed;	// The compiled table could not be written to the cache.
+		TranslationError	baseError;
+		TranslationError	localeError;
+	};
+
+	const char* GetTranslationErrorMessage(TranslationError error)
+	{
+		switch (error) {
+			case kTranslationError_EmptyFile:	return "Empty translation file.";
+			case kTranslationError_BOM:			return "BOM Error, file must be encoded in UCS-2 LE or UTF-8.";
+			case kTranslationError_Encoding:	return "Encoding Error, file must be encoded in UCS-2 LE or UTF-8.";
+			default:							return "";
+		}
+	}
+
+	std::string GetCompiledTablePath(const std::string & modName, const std::string & langCode)
+	{
+		return std::string(MCM_TRANSLATION_CACHE_DIRECTORY "\\") + modName + "_" + langCode + ".bin";
+	}
+
+	// Builds the merged table for one mod, from the compiled cache if possible.
+	// Runs on a worker thread, so errors are stored in the set and logged by the caller.
+	void CompileTranslationSet(TranslationSet & set, const std::string & langCode)
+	{
+		std::string cachePath = GetCompiledTablePath(set.modName, langCode);
+		if (ReadCompiledTable(cachePath, set.sourceHash, &set.table)) {
+			set.cached	= true;
+			set.valid	= true;
+			return;
+		}
+
+		TranslationTable base, locale;
+		bool hasBase	= !set.baseData.empty() && ParseTranslationBuffer(set.baseData, &base, &set.baseError);
+		bool hasLocale	= !set.localeData.empty() && ParseTranslationBuffer(set.localeData, &locale, &set.localeError);
+
+		set.valid = hasBase || hasLocale;
+		if (!set.valid) return;
+
+		MergeTranslationTables(base, locale, &set.table);
+		set.writeFailed = !WriteCompiledTable(cachePath, set.sourceHash, set.table);
+	}
+
+	// Compiles every set on a small pool of worker threads. Sets are independent, so each worker simply takes the next one.
+	void CompileTranslationSets(std::vector<TranslationSet> & sets, const std::string & langCode)
+	{
+		std::atomic<size_t> next { 0 };
+		auto worker = [&sets, &next, &langCode]() {
+			MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Translations);
+			for (size_t i = next++; i < sets.size(); i = next++) {
+				CompileTranslationSet(sets[i], langCode);
+				std::vector<char>().swap(sets[i].baseData);
+				std::vector<char>().swap(sets[i].localeData);
+			}
+		};
+
+		size_t threadCount = (std::min)((size_t)(std::max)(std::thread::hardware_concurrency(), 1u), sets.size());
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < threadCount; i++) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto & thread : threads) {
+			thread.join();
+		}
+	}
+
 	void LoadTranslations(BSScaleformTranslator * translator)
 	{
 		Setting	* setting = GetINISetting("sLanguage:General");
+		std::string langCode = setting->data.s;
 
-		// Load EN strings first to ensure that no strings are unsubstituted if the locale-specific translation is not present.
-		ParseTranslation(translator, "mcm", "en");
+		MCMTelemetry::ScopedSpan span("MCMTranslator::LoadTranslations");
+		MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Translations);
 
-		if (strcmp(setting->data.s, "en") != 0) {
-			ParseTranslation(translator, "mcm", setting->data.s);
+		std::vector<std::string> modNames;
+		modNames.push_back("mcm");
+		for (auto & mod : MCMContentIndex::GetInstance().GetMods()) {
+			if (_stricmp(mod.name.c_str(), "mcm") != 0) modNames.push_back(mod.name);
 		}
+
+		// The game's file system is only used from this thread. Only parsing is done in parallel.
+		// EN strings are merged underneath the locale-specific ones to ensure that no strings are unsubstituted
+		// if the locale-specific translation is not present.
+		std::vector<TranslationSet> sets;
+		for (auto & modName : modNames) {
+			TranslationSet set;
+			bool hasBase	= ReadTranslationFile(modName, "en", &set.baseData);
+			bool hasLocale	= langCode != "en" && ReadTranslationFile(modName, langCode, &set.localeData);
+			if (!hasBase && !hasLocale) continue;
+
+			set.modName		= modName;
+			set.sourceHash	= HashTranslationSources(set.baseData, set.localeData);
+			set.cached		= false;
+			set.valid		= false;
+			set.writeFailed	= false;
+			set.baseError	= kTranslationError_None;
+			set.localeError	= kTranslationError_None;
+			sets.push_back(std::move(set));
+		}
+
+		if (!sets.empty() && GetFileAttributes(MCM_TRANSLATION_CACHE_DIRECTORY) == INVALID_FILE_ATTRIBUTES) {
+			CreateDirectory("Data\\MCM\\Cache", NULL);
+			CreateDirectory(MCM_TRANSLATION_CACHE_DIRECTORY, NULL);
+		}
+
+		CompileTranslationSets(sets, langCode);
+
+		UInt32 entryCount = 0, cachedCount = 0;
+		for (auto & set : sets) {
+			if (set.baseError != kTranslationError_None) {
+				MCM_LOG_MESSAGE("%s_en: %s", set.modName.c_str(), GetTranslationErrorMessage(set.baseError));
+			}
+			if (set.localeError != kTranslationError_None) {
+				MCM_LOG_MESSAGE("%s_%s: %s", set.modName.c_str(), langCode.c_str(), GetTranslationErrorMessage(set.localeError));
+			}
+			if (set.writeFailed) {
+				MCM_LOG_WARNING("Warning: Failed to write compiled translations to %s.", GetCompiledTablePath(set.modName, langCode).c_str());
+			}
+
+			if (set.valid) {
+				ApplyTranslations(translator, set.table);
+				entryCount += set.table.entries.size();
+				if (set.cached) cachedCount++;
+			} else {
+				MCM_LOG_WARNING("Warning: Failed to parse translation files for %s.", set.modName.c_str());
+			}
+		}
+
+		MCM_LOG_MESSAGE("Loaded %d translations for %d mods (%d from cache) in %.3f ms.", entryCount, sets.size(), cachedCount, span.GetElapsed() / 1000.0);
 	}
 
 	bool ParseTranslation(BSScaleformTranslator * translator, std::string modName, std::string langCode)
+	{
+		std::vector<char> data;
+		if (!ReadTranslationFile(modName, langCode, &data)) {
+			MCM_LOG_WARNING("Warning: No translation file available. Locale: %s", langCode.c_str());
+			return false;
+		}
+
+		TranslationTable table;
+		TranslationError error;
+		if (!ParseTranslationBuffer(data, &table, &error)) {
+			MCM_LOG_MESSAGE("%s", GetTranslationErrorMessage(error));
+			return false;
+		}
+
+		ApplyTranslations(translator, table);
+		return true;
+	}
+
+	bool ReadTranslationFile(const std::string & modName, const std::string & langCode, std::vector<char>* data)
 	{
 		std::string filePath = "Interface\\Translations\\";
 		filePath += modName;
 		filePath += "_";
 		filePath += langCode;
 		filePath += ".txt";
-		
+
 		BSResourceNiBinaryStream fileStream(filePath.c_str());
 		if (!fileStream.IsValid()) {
-			_WARNING("Warning: No translation file available. Locale: %s", langCode.c_str());
 			return false;
 		}
 
-		// Check if file is empty, if not check if the BOM is UTF-16
-		UInt16	bom = 0;
-		UInt32	ret = fileStream.Read(&bom, sizeof(UInt16));
-		if (ret == 0) {
-			_MESSAGE("Empty translation file.");
+		// Read the whole file. Archived files do not report their size up front, so read in fixed-size chunks.
+		const UInt32 chunkSize = 64 * 1024;
+		data->clear();
+		while (true) {
+			size_t offset = data->size();
+			data->resize(offset + chunkSize);
+			UInt32 read = fileStream.Read(data->data() + offset, chunkSize);
+			data->resize(offset + read);
+			if (read < chunkSize) break;
+		}
+
+		return true;
+	}
+
+	// Decodes the contents of a translation file to UTF-16, as expected by BSFixedStringW.
+	// UCS-2 LE files must start with a BOM. Anything else is read as UTF-8, with or without a BOM.
+	bool DecodeTranslationBuffer(const std::vector<char> & data, std::vector<wchar_t>* text, TranslationError* error)
+	{
+		const UInt8* bytes = (const UInt8*)data.data();
+		size_t size = data.size();
+
+		if (size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+			size_t length = (size - 2) / sizeof(wchar_t);
+			text->resize(length + 1);
+			memcpy(text->data(), bytes + 2, length * sizeof(wchar_t));
+			(*text)[length] = 0;
+			return true;
+		}
+
+		if (size >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+			*error = kTranslationError_BOM;
 			return false;
 		}
-		if (bom != 0xFEFF) {
-			_MESSAGE("BOM Error, file must be encoded in UCS-2 LE.");
+
+		if (size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+			bytes += 3;
+			size -= 3;
+		}
+
+		if (size == 0) {
+			text->assign(1, 0);
+			return true;
+		}
+
+		int length = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, (LPCSTR)bytes, size, nullptr, 0);
+		if (length <= 0) {
+			*error = kTranslationError_Encoding;
 			return false;
 		}
 
-		while (true)
-		{
-			wchar_t buf[512];
-			UInt32	len = fileStream.ReadLine_w(buf, sizeof(buf) / sizeof(buf[0]), '\n');
-			if (len == 0) // End of file
-				return false;
+		text->resize(length + 1);
+		MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, (LPCSTR)bytes, size, text->data(), length);
+		(*text)[length] = 0;
+		return true;
+	}
 
-			// at least $ + wchar_t + \t + wchar_t
-			if (len < 4 || buf[0] != '$')
-				continue;
+	// Terminates the line [start, end) in place and adds it to the table if it is a translation entry.
+	// lastTab is the position of the last tab on the line, or -1 if there is none.
+	void AddTranslationLine(TranslationTable* table, size_t start, size_t end, size_t lastTab)
+	{
+		std::vector<wchar_t> & text = table->text;
 
-			wchar_t last = buf[len - 1];
-			if (last == '\r')
-				len--;
+		text[end] = 0;
+		if (end > start && text[end - 1] == '\r') {
+			text[--end] = 0;
+		}
 
-			// null terminate
-			buf[len] = 0;
+		// at least $ + wchar_t + \t + wchar_t
+		if (end - start < 4 || text[start] != '$') return;
 
-			UInt32 delimIdx = 0;
-			for (UInt32 i = 0; i < len; i++)
-				if (buf[i] == '\t')
-					delimIdx = i;
+		// at least $ + wchar_t
+		if (lastTab == (size_t)-1 || lastTab < start + 2) return;
 
-			// at least $ + wchar_t
-			if (delimIdx < 2)
-				continue;
+		text[lastTab] = 0;
 
-			// replace \t by \0
-			buf[delimIdx] = 0;
+		TranslationTable::Entry entry;
+		entry.key			= start;
+		entry.translation	= lastTab + 1;
+		table->entries.push_back(entry);
+	}
+
+	bool ParseTranslationBuffer(const std::vector<char> & data, TranslationTable* table, TranslationError* error)
+	{
+		TranslationError unused;
+		if (!error) error = &unused;
+		*error = kTranslationError_None;
 
-			BSFixedString key(buf);
-			BSFixedStringW translation(&buf[delimIdx + 1]);
+		table->text.clear();
+		table->entries.clear();
+
+		if (data.empty()) {
+			*error = kTranslationError_EmptyFile;
+			return false;
+		}
+
+		if (!DecodeTranslationBuffer(data, &table->text, error)) {
+			return false;
+		}
+
+		// Split the whole buffer in a single pass. Newlines and tabs are located eight characters at a time with SSE2,
+		// so the common case of a block containing neither costs one compare per block.
+		const wchar_t* text = table->text.data();
+		size_t length		= table->text.size() - 1;
+		size_t lineStart	= 0;
+		size_t lastTab		= (size_t)-1;
+
+		const __m128i newlines	= _mm_set1_epi16('\n');
+		const __m128i tabs		= _mm_set1_epi16('\t');
+
+		size_t i = 0;
+		for (; i + 8 <= length; i += 8) {
+			__m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+			UInt32 mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(block, newlines), _mm_cmpeq_epi16(block, tabs)));
+
+			// movemask yields two bits per character. Keep one.
+			mask &= 0x5555;
+			while (mask) {
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				mask &= mask - 1;
+
+				size_t pos = i + bit / 2;
+				if (text[pos] == '\t') {
+					lastTab = pos;
+				} else {
+					AddTranslationLine(table, lineStart, pos, lastTab);
+					lineStart	= pos + 1;
+					lastTab		= (size_t)-1;
+				}
+			}
+		}
+
+		for (; i < length; i++) {
+			if (text[i] == '\t') {
+				lastTab = i;
+			} else if (text[i] == '\n') {
+				AddTranslationLine(table, lineStart, i, lastTab);
+				lineStart	= i + 1;
+				lastTab		= (size_t)-1;
+			}
+		}
+
+		if (lineStart < length) {
+			AddTranslationLine(table, lineStart, length, lastTab);
+		}
+
+		return true;
+	}
+
+	void ApplyTranslations(BSScaleformTranslator * translator, const TranslationTable & table)
+	{
+		for (auto & entry : table.entries) {
+			BSFixedString key(&table.text[entry.key]);
+			BSFixedStringW translation(&table.text[entry.translation]);
 
 			TranslationTableItem* existing = translator->translations.Find(&key);
 			if (existing) {
@@ -91,9 +362,141 @@ namespace MCMTranslator
 				TranslationTableItem item(key, translation);
 				translator->translations.Add(&item);
 			}
-			
+		}
+	}
+
+	UInt64 HashTranslationSources(const std::vector<char> & baseData, const std::vector<char> & localeData)
+	{
+		// 64-bit FNV-1a over the length and contents of each file. tools/compile_translations.py must match this.
+		UInt64 hash = 14695981039346656037ULL;
+		auto update = [&hash](const void* data, size_t length) {
+			const UInt8* bytes = (const UInt8*)data;
+			for (size_t i = 0; i < length; i++) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ULL;
+			}
+		};
+
+		UInt64 baseLength = baseData.size(), localeLength = localeData.size();
+		update(&baseLength, sizeof(baseLength));
+		update(baseData.data(), baseData.size());
+		update(&localeLength, sizeof(localeLength));
+		update(localeData.data(), localeData.size());
+		return hash;
+	}
+
+	void MergeTranslationTables(const TranslationTable & base, const TranslationTable & overrides, TranslationTable* merged)
+	{
+		merged->text.clear();
+		merged->entries.clear();
+
+		// Key -> index into entries. Overrides replace the translation but keep the position of the base entry.
+		std::unordered_map<std::wstring, size_t> lookup;
+		std::vector<std::pair<const wchar_t*, const wchar_t*>> entries;
+		size_t textLength = 0;
+
+		for (const TranslationTable* table : { &base, &overrides }) {
+			for (auto & entry : table->entries) {
+				const wchar_t* key			= &table->text[entry.key];
+				const wchar_t* translation	= &table->text[entry.translation];
+
+				auto itr = lookup.find(key);
+				if (itr != lookup.end()) {
+					entries[itr->second].second = translation;
+				} else {
+					lookup.emplace(key, entries.size());
+					entries.push_back(std::make_pair(key, translation));
+				}
+			}
+		}
+
+		for (auto & entry : entries) {
+			textLength += wcslen(entry.first) + wcslen(entry.second) + 2;
+		}
+
+		merged->text.reserve(textLength);
+		merged->entries.reserve(entries.size());
+		for (auto & entry : entries) {
+			TranslationTable::Entry compiled;
+			compiled.key = merged->text.size();
+			merged->text.insert(merged->text.end(), entry.first, entry.first + wcslen(entry.first) + 1);
+			compiled.translation = merged->text.size();
+			merged->text.insert(merged->text.end(), entry.second, entry.second + wcslen(entry.second) + 1);
+			merged->entries.push_back(compiled);
+		}
+	}
+
+	// Compiled table layout (little-endian):
+	//   CompiledTableHeader
+	//   TranslationTable::Entry[entryCount]
+	//   UInt16[textLength]
+	struct CompiledTableHeader
+	{
+		enum { kMagic = 0x544D434D, kVersion = 1 };	// "MCMT"
+
+		UInt32	magic;
+		UInt32	version;
+		UInt64	sourceHash;
+		UInt32	entryCount;
+		UInt32	textLength;
+	};
+	STATIC_ASSERT(sizeof(CompiledTableHeader) == 24);
+	STATIC_ASSERT(sizeof(TranslationTable::Entry) == 8);
+	STATIC_ASSERT(sizeof(wchar_t) == sizeof(UInt16));
+
+	bool ReadCompiledTable(const std::string & path, UInt64 sourceHash, TranslationTable* table)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return false;
+
+		std::streamoff fileSize = file.tellg();
+		if (fileSize < (std::streamoff)sizeof(CompiledTableHeader)) return false;
+
+		std::vector<char> data((size_t)fileSize);
+		file.seekg(0);
+		if (!file.read(data.data(), data.size())) return false;
+
+		const CompiledTableHeader* header = (const CompiledTableHeader*)data.data();
+		if (header->magic != CompiledTableHeader::kMagic || header->version != CompiledTableHeader::kVersion || header->sourceHash != sourceHash) {
+			return false;
+		}
+
+		size_t entriesSize	= (size_t)header->entryCount * sizeof(TranslationTable::Entry);
+		size_t textSize		= (size_t)header->textLength * sizeof(wchar_t);
+		if (data.size() != sizeof(CompiledTableHeader) + entriesSize + textSize) return false;
+
+		const char* entries	= data.data() + sizeof(CompiledTableHeader);
+		const char* text	= entries + entriesSize;
+
+		table->entries.resize(header->entryCount);
+		memcpy(table->entries.data(), entries, entriesSize);
+		table->text.resize(header->textLength);
+		memcpy(table->text.data(), text, textSize);
+
+		// Reject tables whose offsets do not point at null-terminated strings within the text.
+		if (header->textLength == 0 ? header->entryCount != 0 : table->text.back() != 0) return false;
+		for (auto & entry : table->entries) {
+			if (entry.key >= header->textLength || entry.translation >= header->textLength) return false;
 		}
 
 		return true;
 	}
+
+	bool WriteCompiledTable(const std::string & path, UInt64 sourceHash, const TranslationTable & table)
+	{
+		CompiledTableHeader header;
+		header.magic		= CompiledTableHeader::kMagic;
+		header.version		= CompiledTableHeader::kVersion;
+		header.sourceHash	= sourceHash;
+		header.entryCount	= table.entries.size();
+		header.textLength	= table.text.size();
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)table.entries.data(), table.entries.size() * sizeof(TranslationTable::Entry));
+		file.write((const char*)table.text.data(), table.text.size() * sizeof(wchar_t));
+		return file.good();
+	}
 }
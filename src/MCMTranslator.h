@@ -1,11 +1,67 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 // This file is adapted from f4se/Translation.h.
 
 class BSScaleformTranslator;
 
 namespace MCMTranslator
 {
+	// Translations parsed from one or more files, staged for insertion into the translator.
+	// Keys and translations are null-terminated strings stored back-to-back in text, so a table
+	// costs two allocations regardless of the number of entries or the length of each line.
+	struct TranslationTable
+	{
+		struct Entry
+		{
+			UInt32	key;			// Offset of the key in text.
+			UInt32	translation;	// Offset of the translation in text.
+		};
+
+		std::vector<wchar_t>	text;
+		std::vector<Entry>		entries;
+	};
+
+	// Reasons a translation file could not be parsed.
+	enum TranslationError {
+		kTranslationError_None,
+		kTranslationError_EmptyFile,
+		kTranslationError_BOM,
+		kTranslationError_Encoding,
+	};
+
+	// Message for the log, e.g. "Empty translation file.".
+	const char* GetTranslationErrorMessage(TranslationError error);
+
+	// Loads mcm_<lang>.txt and the <mod>_<lang>.txt file of every MCM mod, falling back to English.
+	// Files are read on the calling thread, parsed in parallel and then inserted into the translator in one pass.
+	// The merged EN + locale table of each mod is compiled to Data\MCM\Cache\Translations\<mod>_<lang>.bin and
+	// reused for as long as the hash of the source files matches.
 	void LoadTranslations(BSScaleformTranslator * translator);
+
+	// Loads and inserts a single translation file.
 	bool ParseTranslation(BSScaleformTranslator * translator, std::string modName, std::string langCode);
+
+	// Reads Interface\Translations\<modName>_<langCode>.txt into data. Returns false if the file does not exist.
+	bool ReadTranslationFile(const std::string & modName, const std::string & langCode, std::vector<char>* data);
+
+	// Parses the contents of a translation file into table. Files may be UCS-2 LE (with a BOM) or UTF-8.
+	// Does not touch any game state or the log, so it is safe to call from any thread. On failure, the reason is
+	// stored in error if it is not null.
+	bool ParseTranslationBuffer(const std::vector<char> & data, TranslationTable* table, TranslationError* error = nullptr);
+
+	// Inserts or replaces every entry of table in the translator.
+	void ApplyTranslations(BSScaleformTranslator * translator, const TranslationTable & table);
+
+	// Hash of the source files of a compiled table.
+	UInt64 HashTranslationSources(const std::vector<char> & baseData, const std::vector<char> & localeData);
+
+	// Merges two tables into one with unique keys. Entries in overrides replace entries in base with the same key.
+	void MergeTranslationTables(const TranslationTable & base, const TranslationTable & overrides, TranslationTable* merged);
+
+	// Reads a compiled table. Returns false if the file is missing, malformed or was compiled from different sources.
+	bool ReadCompiledTable(const std::string & path, UInt64 sourceHash, TranslationTable* table);
+	bool WriteCompiledTable(const std::string & path, UInt64 sourceHash, const TranslationTable & table);
 }
@@ -2,10 +2,14 @@
 #include "Config.h"
 #include "SettingStore.h"
 #include "ScaleformMCM.h"
+#include "MCMProfiler.h"
+#include "MCMTelemetry.h"
 
 #include "f4se/PapyrusVM.h"
 #include "f4se/PapyrusNativeFunctions.h"
 
+#include <climits>
+
 #define MCM_NAME "MCM"
 
 namespace PapyrusMCM
@@ -22,6 +26,10 @@ namespace PapyrusMCM
 		ScaleformMCM::RefreshMenu();
 	}
 
+	void RefreshMenuForMod(StaticFunctionTag* base, BSFixedString asModName) {
+		ScaleformMCM::RefreshMenu(asModName.c_str());
+	}
+
 	SInt32 GetModSettingInt(StaticFunctionTag* base, BSFixedString asModName, BSFixedString asModSetting) {
 		return SettingStore::GetInstance().GetModSettingInt(asModName.c_str(), asModSetting.c_str());
 	}
@@ -35,7 +43,7 @@ namespace PapyrusMCM
 	}
 
 	BSFixedString GetModSettingString(StaticFunctionTag* base, BSFixedString asModName, BSFixedString asModSetting) {
-		BSFixedString str(SettingStore::GetInstance().GetModSettingString(asModName.c_str(), asModSetting.c_str()));
+		BSFixedString str(SettingStore::GetInstance().GetModSettingString(asModName.c_str(), asModSetting.c_str()).c_str());
 		return str;
 	}
 
@@ -54,41 +62,76 @@ namespace PapyrusMCM
 	void SetModSettingString(StaticFunctionTag* base, BSFixedString asModName, BSFixedString asModSetting, BSFixedString abValue) {
 		SettingStore::GetInstance().SetModSettingString(asModName.c_str(), asModSetting.c_str(), abValue.c_str());
 	}
+
+	void DumpProfile(StaticFunctionTag* base) {
+		MCMProfiler::DumpProfile();
+		MCMTelemetry::DumpSummary();
+		MCMTelemetry::ExportTrace(MCM_TRACE_LOCATION);
+	}
+
+	SInt32 GetMemoryUsage(StaticFunctionTag* base, BSFixedString asSubsystem) {
+		MCMProfiler::Subsystem subsystem = MCMProfiler::GetSubsystemByName(asSubsystem.c_str());
+		if (subsystem == MCMProfiler::kSubsystem_Count) return -1;
+
+#ifndef MCM_MEMORY_PROFILING
+		// Memory is not accounted in this build.
+		return -1;
+#else
+		UInt64 liveBytes = MCMProfiler::GetMemoryUsage(subsystem).liveBytes;
+		return liveBytes > INT_MAX ? INT_MAX : (SInt32)liveBytes;
+#endif
+	}
+
+	void DumpMemoryUsage(StaticFunctionTag* base) {
+		MCMProfiler::DumpMemoryUsage();
+	}
 }
 
 void PapyrusMCM::RegisterFuncs(VirtualMachine* vm) {
 	vm->RegisterFunction(
-		new NativeFunction0<StaticFunctionTag, bool>("IsInstalled", MCM_NAME, PapyrusMCM::IsInstalled, vm));
+		new NativeFunction0<StaticFunctionTag, bool>("IsInstalled", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:IsInstalled", PapyrusMCM::IsInstalled), vm));
+
+	vm->RegisterFunction(
+		new NativeFunction0<StaticFunctionTag, UInt32>("GetVersionCode", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:GetVersionCode", PapyrusMCM::GetVersionCode), vm));
+
+	vm->RegisterFunction(
+		new NativeFunction0<StaticFunctionTag, void>("RefreshMenu", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:RefreshMenu", PapyrusMCM::RefreshMenu), vm));
+
+	vm->RegisterFunction(
+		new NativeFunction1<StaticFunctionTag, void, BSFixedString>("RefreshMenuForMod", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:RefreshMenuForMod", PapyrusMCM::RefreshMenuForMod), vm));
+
+	vm->RegisterFunction(
+		new NativeFunction2<StaticFunctionTag, SInt32, BSFixedString, BSFixedString>("GetModSettingInt", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:GetModSettingInt", PapyrusMCM::GetModSettingInt), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction0<StaticFunctionTag, UInt32>("GetVersionCode", MCM_NAME, PapyrusMCM::GetVersionCode, vm));
+		new NativeFunction2<StaticFunctionTag, bool, BSFixedString, BSFixedString>("GetModSettingBool", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:GetModSettingBool", PapyrusMCM::GetModSettingBool), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction0<StaticFunctionTag, void>("RefreshMenu", MCM_NAME, PapyrusMCM::RefreshMenu, vm));
+		new NativeFunction2<StaticFunctionTag, float, BSFixedString, BSFixedString>("GetModSettingFloat", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:GetModSettingFloat", PapyrusMCM::GetModSettingFloat), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction2<StaticFunctionTag, SInt32, BSFixedString, BSFixedString>("GetModSettingInt", MCM_NAME, PapyrusMCM::GetModSettingInt, vm));
+		new NativeFunction2<StaticFunctionTag, BSFixedString, BSFixedString, BSFixedString>("GetModSettingString", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:GetModSettingString", PapyrusMCM::GetModSettingString), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction2<StaticFunctionTag, bool, BSFixedString, BSFixedString>("GetModSettingBool", MCM_NAME, PapyrusMCM::GetModSettingBool, vm));
+		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, SInt32>("SetModSettingInt", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:SetModSettingInt", PapyrusMCM::SetModSettingInt), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction2<StaticFunctionTag, float, BSFixedString, BSFixedString>("GetModSettingFloat", MCM_NAME, PapyrusMCM::GetModSettingFloat, vm));
+		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, bool>("SetModSettingBool", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:SetModSettingBool", PapyrusMCM::SetModSettingBool), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction2<StaticFunctionTag, BSFixedString, BSFixedString, BSFixedString>("GetModSettingString", MCM_NAME, PapyrusMCM::GetModSettingString, vm));
+		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, float>("SetModSettingFloat", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:SetModSettingFloat", PapyrusMCM::SetModSettingFloat), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, SInt32>("SetModSettingInt", MCM_NAME, PapyrusMCM::SetModSettingInt, vm));
+		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, BSFixedString>("SetModSettingString", MCM_NAME, MCM_PROFILED_NATIVE("Papyrus:SetModSettingString", PapyrusMCM::SetModSettingString), vm));
 
 	vm->RegisterFunction(
-		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, bool>("SetModSettingBool", MCM_NAME, PapyrusMCM::SetModSettingBool, vm));
+		new NativeFunction0<StaticFunctionTag, void>("DumpProfile", MCM_NAME, PapyrusMCM::DumpProfile, vm));
 
 	vm->RegisterFunction(
-		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, float>("SetModSettingFloat", MCM_NAME, PapyrusMCM::SetModSettingFloat, vm));
+		new NativeFunction1<StaticFunctionTag, SInt32, BSFixedString>("GetMemoryUsage", MCM_NAME, PapyrusMCM::GetMemoryUsage, vm));
 
 	vm->RegisterFunction(
-		new NativeFunction3<StaticFunctionTag, void, BSFixedString, BSFixedString, BSFixedString>("SetModSettingString", MCM_NAME, PapyrusMCM::SetModSettingString, vm));
+		new NativeFunction0<StaticFunctionTag, void>("DumpMemoryUsage", MCM_NAME, PapyrusMCM::DumpMemoryUsage, vm));
 
 	vm->SetFunctionFlags(MCM_NAME, "IsInstalled", IFunction::kFunctionFlag_NoWait);
 	vm->SetFunctionFlags(MCM_NAME, "GetVersionCode", IFunction::kFunctionFlag_NoWait);
@@ -13,12 +13,163 @@
 #include "f4se/GameMenus.h"
 #include "f4se/GameInput.h"
 #include "f4se/InputMap.h"
+#include "f4se/GameThreads.h"
+#include "f4se/PluginAPI.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "Globals.h"
 #include "Config.h"
 #include "Utils.h"
 #include "SettingStore.h"
 #include "MCMKeybinds.h"
+#include "MCMContentIndex.h"
+#include "MCMDocumentCache.h"
+#include "MCMPageValues.h"
+#include "MCMArguments.h"
+#include "MCMFormLists.h"
+#include "MCMProfiler.h"
+#include "MCMLog.h"
+#include "MCMIOWorker.h"
+#include "MCMTelemetry.h"
+
+//-------------------------
+// Menu Session
+//-------------------------
+
+// Holds the MCM movie and its content object for as long as the MCM is open.
+// Input forwarding invokes handlers directly on the cached content object instead of looking up
+// the PauseMenu and resolving a dotted path from the movie root on every event.
+class MCMMenuSession
+{
+public:
+	// Called from OnMCMOpen. Resolves and caches the MCM content object.
+	void Open(GFxMovieRoot* movieRoot)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		// A session that was never closed belongs to a PauseMenu that has since been destroyed.
+		if (m_movieRoot == movieRoot) {
+			m_content.SetUndefined();
+		} else {
+			ForgetContent();
+		}
+		m_movieRoot = nullptr;
+
+		m_openTime = MCMTelemetry::GetTime();
+
+		if (movieRoot->GetVariable(&m_content, "root.mcm_loader.content")) {
+			m_movieRoot = movieRoot;
+		} else {
+			m_content.SetUndefined();
+			MCM_LOG_WARNING("Warning: Unable to resolve MCM content. Input will not be forwarded.");
+		}
+	}
+
+	// Called from OnMCMClose. Drops the cached references and records the session as a telemetry span.
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_content.SetUndefined();
+		m_movieRoot = nullptr;
+		EndSpan();
+	}
+
+	// The PauseMenu can be destroyed without OnMCMClose being called, e.g. when a game is loaded from the MCM.
+	// Every check compares the cached movie with the movie of the current PauseMenu, which also catches a PauseMenu
+	// that was reopened since. On a mismatch the session is abandoned and input forwarding is turned off.
+	// Must be called from the UI thread.
+	bool IsActive()
+	{
+		GFxMovieRoot* movieRoot = m_movieRoot;
+		if (!movieRoot) return false;
+
+		if (GetPauseMenuMovie() != movieRoot) {
+			Abandon();
+			ScaleformMCM::RegisterForInput(false);
+			return false;
+		}
+		return true;
+	}
+
+	// Invokes a function on the MCM content object. Returns false without doing any work if the MCM is not open.
+	bool Invoke(const char* functionName, GFxValue* args, UInt32 numArgs)
+	{
+		if (!IsActive()) return false;
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (!m_movieRoot) return false;
+		return m_content.Invoke(functionName, nullptr, args, numArgs);
+	}
+
+private:
+	static GFxMovieRoot* GetPauseMenuMovie()
+	{
+		static BSFixedString pauseMenuStr("PauseMenu");
+		if (!(*G::ui)->IsMenuOpen(pauseMenuStr)) return nullptr;
+
+		IMenu* menu = (*G::ui)->GetMenu(pauseMenuStr);
+		return menu && menu->movie ? menu->movie->movieRoot : nullptr;
+	}
+
+	// Drops the cached references of a movie that no longer exists. The content object belongs to that movie,
+	// so it is forgotten rather than released.
+	void Abandon()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		ForgetContent();
+		m_movieRoot = nullptr;
+		EndSpan();
+	}
+
+	void ForgetContent()
+	{
+		m_content.objectInterface	= nullptr;
+		m_content.type				= GFxValue::kType_Undefined;
+	}
+
+	void EndSpan()
+	{
+		if (m_openTime) {
+			MCMTelemetry::RecordSpan("MCM Menu", m_openTime, MCMTelemetry::GetTime() - m_openTime);
+			m_openTime = 0;
+		}
+	}
+
+	std::mutex					m_lock;
+	std::atomic<GFxMovieRoot*>	m_movieRoot { nullptr };
+	GFxValue					m_content;	// root.mcm_loader.content
+	UInt64						m_openTime = 0;
+};
+MCMMenuSession g_menuSession;
+
+// RefreshMenu requests are recorded here and serviced at most once per UI frame by a UI task.
+namespace
+{
+	std::mutex					s_refreshLock;
+	std::set<std::string>		s_refreshScope;			// Mods awaiting a refresh. Ignored if s_refreshAll is set.
+	bool						s_refreshAll = false;
+	std::vector<std::string>	s_activeRefreshScope;	// Scope of the refresh currently being performed. Empty = everything.
+	std::atomic<bool>			s_refreshQueued { false };
+	std::atomic<UInt32>			s_refreshesRequested { 0 };
+	std::atomic<UInt32>			s_refreshesPerformed { 0 };
+}
+
+namespace
+{
+	// Profiling output is only written to the log on menu close if bDiagnostics:Debug is set in MCM.ini.
+	// It is always available on request through the Papyrus natives.
+	bool IsDiagnosticsEnabled()
+	{
+		return SettingStore::GetInstance().GetModSettingBool("MCM", "bDiagnostics:Debug");
+	}
+}
+
+extern F4SETaskInterface* g_task;
 
 namespace ScaleformMCM {
 
@@ -48,25 +199,24 @@ namespace ScaleformMCM {
 
 			args->movie->movieRoot->CreateArray(args->result);
 
-			HANDLE hFind;
-			WIN32_FIND_DATA data;
+			MCMContentIndex& index = MCMContentIndex::GetInstance();
+			UInt32 contentFlag = MCMContentIndex::GetContentFlag(filename);
 
-			hFind = FindFirstFile("Data\\MCM\\Config\\*", &data);
-			if (hFind != INVALID_HANDLE_VALUE) {
-				do {
-					if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
-					if (!strcmp(data.cFileName, ".") || !strcmp(data.cFileName, "..")) continue;
-
-					char fullPath[MAX_PATH];
-					snprintf(fullPath, MAX_PATH, "%s%s%s%s", "Data\\MCM\\Config\\", data.cFileName, "\\", filename);
+			std::vector<MCMContentIndex::ModContent> mods = index.GetMods();
+			for (auto & mod : mods) {
+				char fullPath[MAX_PATH];
+				snprintf(fullPath, MAX_PATH, "%s%s%s%s", "Data\\MCM\\Config\\", mod.name.c_str(), "\\", filename);
 
+				if (contentFlag) {
+					if (!(mod.flags & contentFlag)) continue;
+				} else {
+					// Not a file tracked by the content index.
 					if (GetFileAttributes(fullPath) == INVALID_FILE_ATTRIBUTES) continue;
+				}
 
-					GFxValue filePath;
-					filePath.SetString(wantFullPath ? fullPath : data.cFileName);
-					args->result->PushBack(&filePath);
-				} while (FindNextFile(hFind, &data));
-				FindClose(hFind);
+				GFxValue filePath;
+				filePath.SetString(wantFullPath ? fullPath : mod.name.c_str());
+				args->result->PushBack(&filePath);
 			}
 		}
 	};
@@ -75,6 +225,8 @@ namespace ScaleformMCM {
 	class OnMCMOpen : public GFxFunctionHandler {
 	public:
 		virtual void Invoke(Args* args) {
+			g_menuSession.Open(args->movie->movieRoot);
+
 			// Start key handler
 			RegisterForInput(true);
 		}
@@ -87,6 +239,26 @@ namespace ScaleformMCM {
 			// Save modified keybinds.
 			g_keybindManager.CommitKeybinds();
 			RegisterForInput(false);
+
+			// F4SE has no quit notification, and the game can be quit from the PauseMenu right after this.
+			// Wait for the writes made in the menu instead of relying on the shutdown at DLL detach.
+			MCMIOWorker::GetInstance().Flush();
+
+			g_menuSession.Close();
+
+			if (IsDiagnosticsEnabled()) {
+				UInt32 requested, performed;
+				GetRefreshStats(&requested, &performed);
+				MCM_LOG_MESSAGE("Menu refreshes: %d requested, %d performed.", requested, performed);
+
+				MCMDocumentCache::Stats cacheStats = MCMDocumentCache::GetInstance().GetStats();
+				MCM_LOG_MESSAGE("Document cache: %d hits, %d misses, %d evictions, %d documents (%d KB).",
+					cacheStats.hits, cacheStats.misses, cacheStats.evictions, cacheStats.documents, (UInt32)(cacheStats.memoryUsage / 1024));
+
+				MCMProfiler::DumpProfile();
+				MCMProfiler::DumpMemoryUsage();
+				MCMTelemetry::DumpSummary();
+			}
 		}
 	};
 
@@ -111,9 +283,7 @@ namespace ScaleformMCM {
 			if (args->numArgs != 1) return;
 			if (args->args[0].GetType() != GFxValue::kType_String) return;
 
-			TESForm* targetForm = MCMUtils::GetFormFromIdentifier(args->args[0].GetString());
-			TESGlobal* global = nullptr;
-			global = DYNAMIC_CAST(targetForm, TESForm, TESGlobal);
+			TESGlobal* global = MCMUtils::GetGlobalFromIdentifier(args->args[0].GetString());
 
 			if (global) {
 				args->result->SetNumber(global->value);
@@ -131,9 +301,7 @@ namespace ScaleformMCM {
 			if (args->args[0].GetType() != GFxValue::kType_String) return;
 			if (args->args[1].GetType() != GFxValue::kType_Number) return;
 
-			TESForm* targetForm = MCMUtils::GetFormFromIdentifier(args->args[0].GetString());
-			TESGlobal* global = nullptr;
-			global = DYNAMIC_CAST(targetForm, TESForm, TESGlobal);
+			TESGlobal* global = MCMUtils::GetGlobalFromIdentifier(args->args[0].GetString());
 
 			if (global) {
 				global->value = args->args[1].GetNumber();
@@ -142,6 +310,88 @@ namespace ScaleformMCM {
 		}
 	};
 
+	// function GetGlobalValues(formIdentifiers:Array):Object
+	// Returns {values:Array<Number>, failed:Array<String>}. values is aligned with formIdentifiers; entries that could not be
+	// resolved to a global are null and their identifiers are listed in failed.
+	class GetGlobalValues : public GFxFunctionHandler {
+	public:
+		virtual void Invoke(Args* args) {
+			GFxMovieRoot* movieRoot = args->movie->movieRoot;
+			GFxValue values, failed;
+			movieRoot->CreateObject(args->result);
+			movieRoot->CreateArray(&values);
+			movieRoot->CreateArray(&failed);
+			args->result->SetMember("values", &values);
+			args->result->SetMember("failed", &failed);
+
+			if (args->numArgs < 1) return;
+			if (args->args[0].GetType() != GFxValue::kType_Array) return;
+
+			GFxValue & identifiers = args->args[0];
+			UInt32 count = identifiers.GetArraySize();
+			for (UInt32 i = 0; i < count; i++) {
+				GFxValue identifier, value;
+				identifiers.GetElement(i, &identifier);
+
+				TESGlobal* global = nullptr;
+				if (identifier.GetType() == GFxValue::kType_String) {
+					global = MCMUtils::GetGlobalFromIdentifier(identifier.GetString());
+				}
+
+				if (global) {
+					value.SetNumber(global->value);
+				} else {
+					value.SetNull();
+					failed.PushBack(&identifier);
+				}
+				values.PushBack(&value);
+			}
+		}
+	};
+
+	// function SetGlobalValues(newValues:Object):Array<String>
+	// newValues maps form identifiers to numbers, e.g. {"MyMod.esp|F99": 1, "MyMod.esp|F9A": 2.5}.
+	// Returns the identifiers that could not be set. An empty array means every value was set.
+	class SetGlobalValues : public GFxFunctionHandler {
+	public:
+		class GlobalValueVisitor : public GFxValue::ObjectVisitor {
+		public:
+			GlobalValueVisitor(GFxValue* failed) : m_failed(failed) { }
+
+			virtual void Visit(const char* member, GFxValue* value) override {
+				TESGlobal* global = nullptr;
+				if (value->GetType() == GFxValue::kType_Number || value->GetType() == GFxValue::kType_Int || value->GetType() == GFxValue::kType_UInt) {
+					global = MCMUtils::GetGlobalFromIdentifier(member);
+				}
+
+				if (global) {
+					switch (value->GetType()) {
+						case GFxValue::kType_Int:	global->value = value->GetInt();	break;
+						case GFxValue::kType_UInt:	global->value = value->GetUInt();	break;
+						default:					global->value = value->GetNumber();	break;
+					}
+				} else {
+					GFxValue identifier;
+					identifier.SetString(member);
+					m_failed->PushBack(&identifier);
+				}
+			}
+
+		private:
+			GFxValue* m_failed;
+		};
+
+		virtual void Invoke(Args* args) {
+			args->movie->movieRoot->CreateArray(args->result);
+
+			if (args->numArgs < 1) return;
+			if (args->args[0].GetType() != GFxValue::kType_Object) return;
+
+			GlobalValueVisitor visitor(args->result);
+			args->args[0].VisitMembers(&visitor);
+		}
+	};
+
 	// function GetPropertyValue(formIdentifier:String, propertyName:String):*
 	// Returns null if the property doesn't exist.
 	class GetPropertyValue : public GFxFunctionHandler {
@@ -253,7 +503,7 @@ namespace ScaleformMCM {
 			TESForm* targetForm = MCMUtils::GetFormFromIdentifier(args->args[0].GetString());
 
 			if (!targetForm) {
-				_MESSAGE("WARNING: %s is not a valid form.", args->args[0].GetString());
+				MCM_LOG_MESSAGE("WARNING: %s is not a valid form.", args->args[0].GetString());
 			} else {
 				const char* scriptName = args->args[1].GetString();
 
@@ -261,26 +511,17 @@ namespace ScaleformMCM {
 				MCMUtils::VMScript script(targetForm, scriptName);
 
 				if (!script.m_identifier) {
-					_MESSAGE("WARNING: %s cannot be resolved to a Papyrus script object.", args->args[0].GetString());
+					MCM_LOG_MESSAGE("WARNING: %s cannot be resolved to a Papyrus script object.", args->args[0].GetString());
 				} else {
 					BSFixedString funcName(args->args[2].GetString());
 
-					VMValue packedArgs;
-					UInt32 length = args->numArgs - 3;
-					VMValue::ArrayData* arrayData = nullptr;
-					vm->CreateArray(&packedArgs, length, &arrayData);
-
-					packedArgs.type.value = VMValue::kType_VariableArray;
-					packedArgs.data.arr = arrayData;
-
-					for (UInt32 i = 0; i < length; i++)
+					MCMUtils::VMArgumentList arguments(args->numArgs - 3);
+					for (UInt32 i = 0; i < arguments.Count(); i++)
 					{
-						VMValue* var = new VMValue;
-						PlatformAdapter::ConvertScaleformValue(var, &args->args[i + 3], vm);
-						arrayData->arr.entries[i].SetVariable(var);
+						arguments.Set(i, &args->args[i + 3], vm);
 					}
 
-					CallFunctionNoWait_Internal(vm, 0, script.m_identifier, &funcName, &packedArgs);
+					CallFunctionNoWait_Internal(vm, 0, script.m_identifier, &funcName, arguments.Pack(vm));
 
 					args->result->SetBool(true);
 				}
@@ -304,27 +545,49 @@ namespace ScaleformMCM {
 			BSFixedString scriptName(args->args[0].GetString());
 			BSFixedString funcName(args->args[1].GetString());
 			
-			VMValue packedArgs;
-			UInt32 length = args->numArgs - 2;
-			VMValue::ArrayData* arrayData = nullptr;
-			vm->CreateArray(&packedArgs, length, &arrayData);
-
-			packedArgs.type.value = VMValue::kType_VariableArray;
-			packedArgs.data.arr = arrayData;
-
-			for (UInt32 i = 0; i < length; i++)
+			MCMUtils::VMArgumentList arguments(args->numArgs - 2);
+			for (UInt32 i = 0; i < arguments.Count(); i++)
 			{
-				VMValue * var = new VMValue;
-				PlatformAdapter::ConvertScaleformValue(var, &args->args[i + 2], vm);
-				arrayData->arr.entries[i].SetVariable(var);
+				arguments.Set(i, &args->args[i + 2], vm);
 			}
 
-			CallGlobalFunctionNoWait_Internal(vm, 0, 0, &scriptName, &funcName, &packedArgs);
+			CallGlobalFunctionNoWait_Internal(vm, 0, 0, &scriptName, &funcName, arguments.Pack(vm));
 
 			args->result->SetBool(true);
 		}
 	};
 
+	// function GetRefreshScope():Array
+	// Returns the mod names affected by the refresh currently in progress. An empty array means all mods should refresh.
+	class GetRefreshScope : public GFxFunctionHandler {
+	public:
+		virtual void Invoke(Args* args) {
+			args->movie->movieRoot->CreateArray(args->result);
+
+			std::lock_guard<std::mutex> lock(s_refreshLock);
+			for (auto & modName : s_activeRefreshScope) {
+				GFxValue value;
+				args->movie->movieRoot->CreateString(&value, modName.c_str());
+				args->result->PushBack(&value);
+			}
+		}
+	};
+
+	// function ResolvePageValues(modName:String, pageId:*):Array
+	// pageId is a page index (-1 for the root content) or a pageDisplayName.
+	// Returns the current value of every control on the page, aligned with the page's content array. Controls without a valueSource are null.
+	class ResolvePageValues : public GFxFunctionHandler {
+	public:
+		virtual void Invoke(Args* args) {
+			args->movie->movieRoot->CreateArray(args->result);
+
+			if (args->numArgs < 2) return;
+			if (args->args[0].GetType() != GFxValue::kType_String) return;
+
+			MCMPageValues::ResolvePageValues(args->movie->movieRoot, args->args[0].GetString(), &args->args[1], args->result);
+		}
+	};
+
 	// GetModSettingInt(modName:String, settingName:String):int;
 	class GetModSettingInt : public GFxFunctionHandler {
 	public:
@@ -377,7 +640,8 @@ namespace ScaleformMCM {
 			if (args->args[0].GetType() != GFxValue::kType_String) return;
 			if (args->args[1].GetType() != GFxValue::kType_String) return;
 
-			args->result->SetString(SettingStore::GetInstance().GetModSettingString(args->args[0].GetString(), args->args[1].GetString()));
+			std::string value = SettingStore::GetInstance().GetModSettingString(args->args[0].GetString(), args->args[1].GetString());
+			args->movie->movieRoot->CreateString(args->result, value.c_str());
 		}
 	};
 
@@ -521,6 +785,55 @@ namespace ScaleformMCM {
 		}
 	};
 
+	// function GetKeybindsSince(version:int):Object
+	// Returns {version:int, changed:Array, removed:Array} where changed contains keybind info objects added or modified
+	// after the specified version, and removed contains {keycode, modifiers} for keybinds cleared since then.
+	// Pass 0 to retrieve all keybinds, then pass the returned version on subsequent calls.
+	class GetKeybindsSince : public GFxFunctionHandler {
+	public:
+		virtual void Invoke(Args* args) {
+			UInt32 sinceVersion = 0;
+			if (args->numArgs > 0) {
+				if (args->args[0].GetType() == GFxValue::kType_Int)			sinceVersion = args->args[0].GetInt();
+				else if (args->args[0].GetType() == GFxValue::kType_UInt)	sinceVersion = args->args[0].GetUInt();
+			}
+
+			std::vector<KeybindInfo>	changed;
+			std::vector<Keybind>		removed;
+
+			g_keybindManager.Lock();
+			UInt32 currentVersion = g_keybindManager.GetKeybindsSince(sinceVersion, changed, removed);
+			g_keybindManager.Release();
+
+			GFxMovieRoot* movieRoot = args->movie->movieRoot;
+			GFxValue version, changedValue, removedValue;
+			version.SetInt(currentVersion);
+			movieRoot->CreateArray(&changedValue);
+			movieRoot->CreateArray(&removedValue);
+
+			for (auto & ki : changed) {
+				GFxValue keybindInfoValue;
+				SetKeybindInfo(ki, movieRoot, &keybindInfoValue);
+				changedValue.PushBack(&keybindInfoValue);
+			}
+
+			for (auto & kb : removed) {
+				GFxValue removedKeybind, keycode, modifiers;
+				movieRoot->CreateObject(&removedKeybind);
+				keycode.SetInt(kb.keycode);
+				modifiers.SetInt(kb.modifiers);
+				removedKeybind.SetMember("keycode", &keycode);
+				removedKeybind.SetMember("modifiers", &modifiers);
+				removedValue.PushBack(&removedKeybind);
+			}
+
+			movieRoot->CreateObject(args->result);
+			args->result->SetMember("version", &version);
+			args->result->SetMember("changed", &changedValue);
+			args->result->SetMember("removed", &removedValue);
+		}
+	};
+
 	// function SetKeybind(modName:String, keybindID:String, keycode:int, modifiers:int):Boolean
 	class SetKeybind : public GFxFunctionHandler {
 	public:
@@ -583,7 +896,7 @@ namespace ScaleformMCM {
 
 					TESForm* targetForm = MCMUtils::GetFormFromIdentifier(targetFormIdentifier.GetString());
 					if (!targetForm) {
-						_WARNING("Cannot register a None form as a call target.");
+						MCM_LOG_WARNING("Cannot register a None form as a call target.");
 						return;
 					}
 
@@ -592,7 +905,7 @@ namespace ScaleformMCM {
 
 					g_keybindManager.Register(kb, kp);
 
-					_MESSAGE("Succesfully registered kType_CallFunction keybind for keycode %d.", kb.keycode);
+					MCM_LOG_MESSAGE("Succesfully registered kType_CallFunction keybind for keycode %d.", kb.keycode);
 
 					break;
 				}
@@ -611,7 +924,7 @@ namespace ScaleformMCM {
 
 					g_keybindManager.Register(kb, kp);
 
-					_MESSAGE("Succesfully registered kType_CallGlobalFunction keybind for keycode %d.", kb.keycode);
+					MCM_LOG_MESSAGE("Succesfully registered kType_CallGlobalFunction keybind for keycode %d.", kb.keycode);
 
 					break;
 				}
@@ -627,17 +940,17 @@ namespace ScaleformMCM {
 
 					g_keybindManager.Register(kb, kp);
 
-					_MESSAGE("Succesfully registered kType_RunConsoleCommand keybind for keycode %d.", kb.keycode);
+					MCM_LOG_MESSAGE("Succesfully registered kType_RunConsoleCommand keybind for keycode %d.", kb.keycode);
 
 					break;
 				}
 				case KeybindParameters::kType_SendEvent:
 				{
-					_MESSAGE("Not implemented.");
+					MCM_LOG_MESSAGE("Not implemented.");
 					break;
 				}
 				default:
-					_WARNING("Failed to register keybind. Unknown keybind type.");
+					MCM_LOG_WARNING("Failed to register keybind. Unknown keybind type.");
 			}
 		}
 	};
@@ -724,81 +1037,180 @@ namespace ScaleformMCM {
 		}
 	};
 
+	BGSListForm* GetFormListArg(GFxFunctionHandler::Args* args)
+	{
+		if (args->numArgs < 1) return nullptr;
+		if (args->args[0].GetType() != GFxValue::kType_String) return nullptr; // formIdentifier
+
+		TESForm* form = MCMUtils::GetFormFromIdentifier(args->args[0].GetString());
+		if (!form) return nullptr;
+		return DYNAMIC_CAST(form, TESForm, BGSListForm);
+	}
+
 	// function GetListFromForm(formIdentifier:String):Array<String>
 	class GetListFromForm : public GFxFunctionHandler {
 	public:
 		virtual void Invoke(Args* args) {
 			args->movie->movieRoot->CreateArray(args->result);
 
-			if (args->numArgs < 1) return;
-			if (args->args[0].GetType() != GFxValue::kType_String) return; // formIdentifier
+			BGSListForm* formlist = GetFormListArg(args);
+			if (!formlist) return;
 
-			TESForm* form = MCMUtils::GetFormFromIdentifier(args->args[0].GetString());
-			if (!form) return;
-			BGSListForm* formlist = DYNAMIC_CAST(form, TESForm, BGSListForm);
+			MCMFormLists::NameList* list = MCMFormLists::GetNames(formlist);
+			for (auto & name : list->names)
+			{
+				GFxValue value;
+				args->movie->movieRoot->CreateString(&value, name.c_str());
+				args->result->PushBack(&value);
+			}
+		}
+	};
+
+	// function GetListFromFormRange(formIdentifier:String, offset:int, count:int):Array<String>
+	// Returns at most count names starting at offset.
+	class GetListFromFormRange : public GFxFunctionHandler {
+	public:
+		virtual void Invoke(Args* args) {
+			args->movie->movieRoot->CreateArray(args->result);
+
+			if (args->numArgs < 3) return;
+			if (args->args[1].GetType() != GFxValue::kType_Int) return; // offset
+			if (args->args[2].GetType() != GFxValue::kType_Int) return; // count
+
+			BGSListForm* formlist = GetFormListArg(args);
 			if (!formlist) return;
-			
-			for (size_t i = 0; i < formlist->forms.count; i++)
+
+			SInt32 offset	= args->args[1].GetInt();
+			SInt32 count	= args->args[2].GetInt();
+			if (offset < 0 || count <= 0) return;
+
+			MCMFormLists::NameList* list = MCMFormLists::GetNames(formlist);
+			for (size_t i = offset; i < list->names.size() && i < (size_t)offset + count; i++)
 			{
-				form = formlist->forms.entries[i];
 				GFxValue value;
-				args->movie->movieRoot->CreateString(&value, "");
-				TESFullName* fullname = DYNAMIC_CAST(form, TESForm, TESFullName);
-				value.SetString(fullname ? fullname->name.c_str() : form->GetEditorID());
+				args->movie->movieRoot->CreateString(&value, list->names[i].c_str());
 				args->result->PushBack(&value);
+			}
+		}
+	};
+
+	// function FindInListFromForm(formIdentifier:String, query:String, prefixOnly:Boolean=true, maxResults:int=0):Array
+	// Returns [{index:int, name:String}, ...] for entries whose name matches the query (case-insensitive).
+	class FindInListFromForm : public GFxFunctionHandler {
+	public:
+		virtual void Invoke(Args* args) {
+			args->movie->movieRoot->CreateArray(args->result);
+
+			if (args->numArgs < 2) return;
+			if (args->args[1].GetType() != GFxValue::kType_String) return; // query
+			bool	prefixOnly	= (args->numArgs > 2 && args->args[2].GetType() == GFxValue::kType_Bool) ? args->args[2].GetBool() : true;
+			SInt32	maxResults	= (args->numArgs > 3 && args->args[3].GetType() == GFxValue::kType_Int) ? args->args[3].GetInt() : 0;
+
+			BGSListForm* formlist = GetFormListArg(args);
+			if (!formlist) return;
+
+			MCMFormLists::NameList* list = MCMFormLists::GetNames(formlist);
+			std::vector<UInt32> matches = MCMFormLists::Find(list, args->args[1].GetString(), prefixOnly, maxResults > 0 ? maxResults : 0);
+			for (auto idx : matches)
+			{
+				GFxValue match, index, name;
+				args->movie->movieRoot->CreateObject(&match);
+				index.SetInt(idx);
+				args->movie->movieRoot->CreateString(&name, list->names[idx].c_str());
+				match.SetMember("index", &index);
+				match.SetMember("name", &name);
+				args->result->PushBack(&match);
 			}
 		}
 	};
 }
 
+//-------------------------
+// Profiling
+//-------------------------
+
+// Wraps a Scaleform function handler so that its calls are recorded by MCMProfiler.
+template <typename T>
+class ProfiledFunctionHandler : public T
+{
+public:
+	virtual void Invoke(GFxFunctionHandler::Args* args) override
+	{
+		MCMProfiler::ScopedCall call(s_id);
+		T::Invoke(args);
+	}
+
+	static UInt32 s_id;
+};
+
+template <typename T>
+UInt32 ProfiledFunctionHandler<T>::s_id = 0;
+
+template <typename T>
+void RegisterProfiledFunction(GFxValue* dst, GFxMovieRoot* movieRoot, const char* name)
+{
+	std::string profileName = "Scaleform:";
+	profileName += name;
+	ProfiledFunctionHandler<T>::s_id = MCMProfiler::RegisterNative(profileName.c_str());
+	RegisterFunction<ProfiledFunctionHandler<T>>(dst, movieRoot, name);
+}
+
 void ScaleformMCM::RegisterFuncs(GFxValue* codeObj, GFxMovieRoot* movieRoot) {
 	// MCM Data
-	RegisterFunction<GetMCMVersionString>(codeObj, movieRoot, "GetMCMVersionString");
-	RegisterFunction<GetMCMVersionCode>(codeObj, movieRoot, "GetMCMVersionCode");
-	RegisterFunction<GetConfigList>(codeObj, movieRoot, "GetConfigList");
+	RegisterProfiledFunction<GetMCMVersionString>(codeObj, movieRoot, "GetMCMVersionString");
+	RegisterProfiledFunction<GetMCMVersionCode>(codeObj, movieRoot, "GetMCMVersionCode");
+	RegisterProfiledFunction<GetConfigList>(codeObj, movieRoot, "GetConfigList");
 
 	// MCM Events
-	RegisterFunction<OnMCMOpen>(codeObj, movieRoot, "OnMCMOpen");
-	RegisterFunction<OnMCMClose>(codeObj, movieRoot, "OnMCMClose");
+	RegisterProfiledFunction<OnMCMOpen>(codeObj, movieRoot, "OnMCMOpen");
+	RegisterProfiledFunction<OnMCMClose>(codeObj, movieRoot, "OnMCMClose");
+	RegisterProfiledFunction<GetRefreshScope>(codeObj, movieRoot, "GetRefreshScope");
 
 	// MCM Utilities
-	RegisterFunction<DisableMenuInput>(codeObj, movieRoot, "DisableMenuInput");
+	RegisterProfiledFunction<DisableMenuInput>(codeObj, movieRoot, "DisableMenuInput");
 
 	// Actions
-	RegisterFunction<GetGlobalValue>(codeObj, movieRoot, "GetGlobalValue");
-	RegisterFunction<SetGlobalValue>(codeObj, movieRoot, "SetGlobalValue");
-	RegisterFunction<GetPropertyValue>(codeObj, movieRoot, "GetPropertyValue");
-	RegisterFunction<SetPropertyValue>(codeObj, movieRoot, "SetPropertyValue");
-	RegisterFunction<GetPropertyValueEx>(codeObj, movieRoot, "GetPropertyValueEx");
-	RegisterFunction<SetPropertyValueEx>(codeObj, movieRoot, "SetPropertyValueEx");
-	RegisterFunction<CallQuestFunction>(codeObj, movieRoot, "CallQuestFunction");
-	RegisterFunction<CallGlobalFunction>(codeObj, movieRoot, "CallGlobalFunction");
+	RegisterProfiledFunction<GetGlobalValue>(codeObj, movieRoot, "GetGlobalValue");
+	RegisterProfiledFunction<SetGlobalValue>(codeObj, movieRoot, "SetGlobalValue");
+	RegisterProfiledFunction<GetGlobalValues>(codeObj, movieRoot, "GetGlobalValues");
+	RegisterProfiledFunction<SetGlobalValues>(codeObj, movieRoot, "SetGlobalValues");
+	RegisterProfiledFunction<GetPropertyValue>(codeObj, movieRoot, "GetPropertyValue");
+	RegisterProfiledFunction<SetPropertyValue>(codeObj, movieRoot, "SetPropertyValue");
+	RegisterProfiledFunction<GetPropertyValueEx>(codeObj, movieRoot, "GetPropertyValueEx");
+	RegisterProfiledFunction<SetPropertyValueEx>(codeObj, movieRoot, "SetPropertyValueEx");
+	RegisterProfiledFunction<CallQuestFunction>(codeObj, movieRoot, "CallQuestFunction");
+	RegisterProfiledFunction<CallGlobalFunction>(codeObj, movieRoot, "CallGlobalFunction");
 
 	// Mod Settings
-	RegisterFunction<GetModSettingInt>(codeObj, movieRoot, "GetModSettingInt");
-	RegisterFunction<GetModSettingBool>(codeObj, movieRoot, "GetModSettingBool");
-	RegisterFunction<GetModSettingFloat>(codeObj, movieRoot, "GetModSettingFloat");
-	RegisterFunction<GetModSettingString>(codeObj, movieRoot, "GetModSettingString");
+	RegisterProfiledFunction<GetModSettingInt>(codeObj, movieRoot, "GetModSettingInt");
+	RegisterProfiledFunction<GetModSettingBool>(codeObj, movieRoot, "GetModSettingBool");
+	RegisterProfiledFunction<GetModSettingFloat>(codeObj, movieRoot, "GetModSettingFloat");
+	RegisterProfiledFunction<GetModSettingString>(codeObj, movieRoot, "GetModSettingString");
+
+	RegisterProfiledFunction<SetModSettingInt>(codeObj, movieRoot, "SetModSettingInt");
+	RegisterProfiledFunction<SetModSettingBool>(codeObj, movieRoot, "SetModSettingBool");
+	RegisterProfiledFunction<SetModSettingFloat>(codeObj, movieRoot, "SetModSettingFloat");
+	RegisterProfiledFunction<SetModSettingString>(codeObj, movieRoot, "SetModSettingString");
 
-	RegisterFunction<SetModSettingInt>(codeObj, movieRoot, "SetModSettingInt");
-	RegisterFunction<SetModSettingBool>(codeObj, movieRoot, "SetModSettingBool");
-	RegisterFunction<SetModSettingFloat>(codeObj, movieRoot, "SetModSettingFloat");
-	RegisterFunction<SetModSettingString>(codeObj, movieRoot, "SetModSettingString");
+	RegisterProfiledFunction<ResolvePageValues>(codeObj, movieRoot, "ResolvePageValues");
 
 	// Mod Info
-	RegisterFunction<IsPluginInstalled>(codeObj, movieRoot, "IsPluginInstalled");
+	RegisterProfiledFunction<IsPluginInstalled>(codeObj, movieRoot, "IsPluginInstalled");
 
 	// Keybinds
-	RegisterFunction<GetKeybind>(codeObj, movieRoot, "GetKeybind");
-	RegisterFunction<GetAllKeybinds>(codeObj, movieRoot, "GetAllKeybinds");
-	RegisterFunction<SetKeybind>(codeObj, movieRoot, "SetKeybind");
-	RegisterFunction<ClearKeybind>(codeObj, movieRoot, "ClearKeybind");
-	RegisterFunction<RemapKeybind>(codeObj, movieRoot, "RemapKeybind");
+	RegisterProfiledFunction<GetKeybind>(codeObj, movieRoot, "GetKeybind");
+	RegisterProfiledFunction<GetAllKeybinds>(codeObj, movieRoot, "GetAllKeybinds");
+	RegisterProfiledFunction<GetKeybindsSince>(codeObj, movieRoot, "GetKeybindsSince");
+	RegisterProfiledFunction<SetKeybind>(codeObj, movieRoot, "SetKeybind");
+	RegisterProfiledFunction<ClearKeybind>(codeObj, movieRoot, "ClearKeybind");
+	RegisterProfiledFunction<RemapKeybind>(codeObj, movieRoot, "RemapKeybind");
 
 	// 
-	RegisterFunction<GetFullName>(codeObj, movieRoot, "GetFullName");
-	RegisterFunction<GetDescription>(codeObj, movieRoot, "GetDescription");
-	RegisterFunction<GetListFromForm>(codeObj, movieRoot, "GetListFromForm");
+	RegisterProfiledFunction<GetFullName>(codeObj, movieRoot, "GetFullName");
+	RegisterProfiledFunction<GetDescription>(codeObj, movieRoot, "GetDescription");
+	RegisterProfiledFunction<GetListFromForm>(codeObj, movieRoot, "GetListFromForm");
+	RegisterProfiledFunction<GetListFromFormRange>(codeObj, movieRoot, "GetListFromFormRange");
+	RegisterProfiledFunction<FindInListFromForm>(codeObj, movieRoot, "FindInListFromForm");
 }
 
 //-------------------------
@@ -846,39 +1258,86 @@ F4SEInputHandler g_scaleformInputHandler;
 
 void ScaleformMCM::ProcessKeyEvent(UInt32 keyCode, bool isDown)
 {
-	BSFixedString mainMenuStr("PauseMenu");
-	if ((*G::ui)->IsMenuOpen(mainMenuStr)) {
-		IMenu* menu = (*G::ui)->GetMenu(mainMenuStr);
-		GFxMovieRoot* movieRoot = menu->movie->movieRoot;
-		GFxValue args[2];
-		args[0].SetInt(keyCode);
-		args[1].SetBool(isDown);
-		movieRoot->Invoke("root.mcm_loader.content.ProcessKeyEvent", nullptr, args, 2);
-	}
+	if (!g_menuSession.IsActive()) return;
+
+	GFxValue args[2];
+	args[0].SetInt(keyCode);
+	args[1].SetBool(isDown);
+	g_menuSession.Invoke("ProcessKeyEvent", args, 2);
 }
 
 void ScaleformMCM::ProcessUserEvent(const char * controlName, bool isDown, int deviceType)
 {
-	BSFixedString mainMenuStr("PauseMenu");
-	if ((*G::ui)->IsMenuOpen(mainMenuStr)) {
-		IMenu* menu = (*G::ui)->GetMenu(mainMenuStr);
-		GFxMovieRoot* movieRoot = menu->movie->movieRoot;
-		GFxValue args[3];
-		args[0].SetString(controlName);
-		args[1].SetBool(isDown);
-		args[2].SetInt(deviceType);
-		movieRoot->Invoke("root.mcm_loader.content.ProcessUserEvent", nullptr, args, 3);
+	if (!g_menuSession.IsActive()) return;
+
+	GFxValue args[3];
+	args[0].SetString(controlName);
+	args[1].SetBool(isDown);
+	args[2].SetInt(deviceType);
+	g_menuSession.Invoke("ProcessUserEvent", args, 3);
+}
+
+//-------------------------
+// Refresh Coalescing
+//-------------------------
+
+namespace
+{
+	void PerformRefresh()
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_refreshLock);
+			s_refreshQueued = false;
+			s_activeRefreshScope.clear();
+			if (!s_refreshAll) {
+				s_activeRefreshScope.assign(s_refreshScope.begin(), s_refreshScope.end());
+			}
+			s_refreshAll = false;
+			s_refreshScope.clear();
+		}
+
+		// Invoke does nothing if the menu isn't open.
+		if (g_menuSession.Invoke("RefreshMCM", nullptr, 0)) {
+			s_refreshesPerformed++;
+		}
 	}
+
+	class RefreshMenuTask : public ITaskDelegate
+	{
+	public:
+		virtual void Run() override
+		{
+			PerformRefresh();
+		}
+	};
 }
 
-void ScaleformMCM::RefreshMenu()
+// Called from Papyrus. Only records the request; the menu session is checked and invoked on the UI thread.
+void ScaleformMCM::RefreshMenu(const char* modName)
 {
-	BSFixedString mainMenuStr("PauseMenu");
-	if ((*G::ui)->IsMenuOpen(mainMenuStr)) {
-		IMenu* menu = (*G::ui)->GetMenu(mainMenuStr);
-		GFxMovieRoot* movieRoot = menu->movie->movieRoot;
-		movieRoot->Invoke("root.mcm_loader.content.RefreshMCM", nullptr, nullptr, 0);
+	s_refreshesRequested++;
+
+	if (!g_task) return;
+
+	{
+		std::lock_guard<std::mutex> lock(s_refreshLock);
+		if (modName && modName[0]) {
+			s_refreshScope.insert(modName);
+		} else {
+			s_refreshAll = true;
+		}
 	}
+
+	// Only one task is queued per frame; later requests are folded into it.
+	if (s_refreshQueued.exchange(true)) return;
+
+	g_task->AddUITask(new RefreshMenuTask());
+}
+
+void ScaleformMCM::GetRefreshStats(UInt32* requested, UInt32* performed)
+{
+	if (requested) *requested = s_refreshesRequested;
+	if (performed) *performed = s_refreshesPerformed;
 }
 
 void ScaleformMCM::SetKeybindInfo(KeybindInfo ki, GFxMovieRoot * movieRoot, GFxValue * kiValue)
@@ -917,7 +1376,7 @@ void ScaleformMCM::RegisterForInput(bool bRegister) {
 		int idx = inputEvents->GetItemIndex(inputHandler);
 		if (idx == -1) {
 			inputEvents->Push(&g_scaleformInputHandler);
-			_MESSAGE("Registered for input events.");
+			MCM_LOG_MESSAGE("Registered for input events.");
 		}
 	} else {
 		g_scaleformInputHandler.enabled = false;
@@ -934,7 +1393,7 @@ bool ScaleformMCM::RegisterScaleform(GFxMovieView * view, GFxValue * f4se_root)
 	if (movieRoot->GetVariable(&currentSWFPath, "root.loaderInfo.url")) {
 		currentSWFPathString = currentSWFPath.GetString();
 	} else {
-		_MESSAGE("WARNING: Scaleform registration failed.");
+		MCM_LOG_MESSAGE("WARNING: Scaleform registration failed.");
 	}
 
 	// Look for the menu that we want to inject into.
@@ -957,7 +1416,7 @@ bool ScaleformMCM::RegisterScaleform(GFxMovieView * view, GFxValue * f4se_root)
 		movieRoot->Invoke("root.Menu_mc.addChild", nullptr, &loader, 1);
 
 		if (!injectionSuccess) {
-			_MESSAGE("WARNING: MCM injection failed.");
+			MCM_LOG_MESSAGE("WARNING: MCM injection failed.");
 		}
 	}
 
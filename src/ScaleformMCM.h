@@ -16,5 +16,10 @@ namespace ScaleformMCM
 	void ProcessUserEvent(const char* controlName, bool isDown, int deviceType);
 
 	void SetKeybindInfo(KeybindInfo ki, GFxMovieRoot* movieRoot, GFxValue* kiValue);
-	void RefreshMenu();
+
+	// Requests a menu refresh. Requests are coalesced and serviced once per UI frame.
+	// If modName is specified, only that mod's page needs to refresh. The scope is exposed to the menu through
+	// GetRefreshScope, but the menu does not use it yet, so every refresh is currently a full refresh.
+	void RefreshMenu(const char* modName = nullptr);
+	void GetRefreshStats(UInt32* requested, UInt32* performed);
 }
\ No newline at end of file
@@ -1,5 +1,13 @@
 #include "SettingStore.h"
-
+#include "MCMContentIndex.h"
+#include "MCMIOWorker.h"
+#include "MCMLog.h"
+#include "MCMTelemetry.h"
+#include "MCMProfiler.h"
+#include "MCMStringPool.h"
+#include "MCMPluginAPI.h"
+
+#include <algorithm>
 #include <string>
 
 // reg2k
@@ -12,7 +20,7 @@ Setting::~Setting() {
 
 SettingStore::SettingStore()
 {
-	_MESSAGE("ModSettingStore initializing.");
+	MCM_LOG_MESSAGE("ModSettingStore initializing.");
 }
 
 SInt32 SettingStore::GetModSettingInt(std::string modName, std::string settingName)
@@ -69,24 +77,51 @@ void SettingStore::SetModSettingFloat(std::string modName, std::string settingNa
 	}
 }
 
-char* SettingStore::GetModSettingString(std::string modName, std::string settingName)
+std::string SettingStore::GetModSettingString(std::string modName, std::string settingName)
 {
 	Setting* ms = GetModSetting(modName, settingName);
 	if (ms) {
-		return ms->data.s;
+		return GetModSettingString(ms);
 	}
-	return nullptr;
+	return std::string();
 }
 
 void SettingStore::SetModSettingString(std::string modName, std::string settingName, const char* newValue)
 {
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Settings);
+
 	Setting* ms = GetModSetting(modName, settingName);
-	if (ms && strcmp(ms->data.s, newValue) != 0) {
+	if (!ms) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_stringLock);
+		if (ms->data.s && strcmp(ms->data.s, newValue) == 0) return;
+
+		char* newString = new char[strlen(newValue)+1];
+		strcpy_s(newString, strlen(newValue) + 1, newValue);
 		if (ms->data.s) delete ms->data.s;
-		ms->data.s = new char[strlen(newValue)+1];
-		strcpy_s(ms->data.s, strlen(newValue) + 1, newValue);
-		CommitModSetting(modName, ms);
+		ms->data.s = newString;
 	}
+	CommitModSetting(modName, ms);
+}
+
+UInt32 SettingStore::CopyModSettingString(Setting* modSetting, char* buffer, UInt32 bufferSize)
+{
+	std::lock_guard<std::mutex> lock(m_stringLock);
+	const char* value = modSetting->data.s ? modSetting->data.s : "";
+	UInt32 length = strlen(value);
+	if (buffer && bufferSize) {
+		UInt32 copyLength = (std::min)(length, bufferSize - 1);
+		memcpy(buffer, value, copyLength);
+		buffer[copyLength] = '\0';
+	}
+	return length;
+}
+
+std::string SettingStore::GetModSettingString(Setting* modSetting)
+{
+	std::lock_guard<std::mutex> lock(m_stringLock);
+	return modSetting->data.s ? modSetting->data.s : "";
 }
 
 // Read ModSettings from filesystem.
@@ -98,45 +133,51 @@ void SettingStore::ReadSettings() {
 	//		- Get all key/value pairs in each section with GetPrivateProfileSection
 	// - Store them in m_settingStore
 
-	LARGE_INTEGER countStart, countEnd, frequency;
-	QueryPerformanceCounter(&countStart);
-	QueryPerformanceFrequency(&frequency);
+	MCMTelemetry::ScopedSpan span("SettingStore::ReadSettings");
+	MCMProfiler::ScopedAllocationTag tag(MCMProfiler::kSubsystem_Settings);
 
 	LoadDefaults();
 	LoadUserSettings();
 
-	QueryPerformanceCounter(&countEnd);
-	long long int elapsed = (countEnd.QuadPart - countStart.QuadPart) / (frequency.QuadPart / 1000);
-	_MESSAGE("Registered %d mod settings in %llu ms.", m_settingStore.size(), elapsed);
+	MCM_LOG_MESSAGE("Registered %d mod settings in %.3f ms.", m_settingStore.size(), span.GetElapsed() / 1000.0);
+}
+
+void SettingStore::ReadSettingsAsync() {
+	// Nothing reads a setting until Papyrus or the menu runs, so the game does not need to wait for the parse.
+	// m_loaded is only cleared once m_loadTask holds the future, so a reader that sees it cleared always has a task to wait on.
+	m_loadTask = MCMIOWorker::GetInstance().Submit(MCMIOWorker::kPriority_Interactive, [this]() {
+		try {
+			ReadSettings();
+		} catch (...) {
+			MCM_LOG_ERROR("Error: Failed to read mod settings.");
+		}
+	}).share();
+	m_loaded.store(false, std::memory_order_release);
 }
 
 //----------------------
 // Private Functions
 //----------------------
 
-void SettingStore::LoadDefaults() {
-	// Find all defaults.ini files.
-	HANDLE hFind;
-	WIN32_FIND_DATA data;
-
-	hFind = FindFirstFile("Data\\MCM\\Config\\*", &data);
-	if (hFind != INVALID_HANDLE_VALUE) {
-		do {
-			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
-			if (!strcmp(data.cFileName, ".") || !strcmp(data.cFileName, "..")) continue;
+void SettingStore::WaitUntilLoaded() {
+	if (m_loaded.load(std::memory_order_acquire)) return;
 
-			char fullPath[MAX_PATH];
-			snprintf(fullPath, MAX_PATH, "%s%s%s", "Data\\MCM\\Config\\", data.cFileName, "\\settings.ini");
+	MCMTelemetry::ScopedSpan span("SettingStore::WaitUntilLoaded");
 
-			if (GetFileAttributes(fullPath) == INVALID_FILE_ATTRIBUTES) continue;
+	if (m_loadTask.valid()) m_loadTask.wait();
+	m_loaded.store(true, std::memory_order_release);
 
-			//_MESSAGE("name %s path %s", data.cFileName, fullPath);
+	MCM_LOG_MESSAGE("Waited %.3f ms for mod settings to finish loading.", span.GetElapsed() / 1000.0);
+}
 
-			// Read into settings
-			ReadINI(data.cFileName, fullPath);
+void SettingStore::LoadDefaults() {
+	// Find all settings.ini files.
+	std::vector<std::string> mods = MCMContentIndex::GetInstance().GetModsWithContent(MCMContentIndex::kContent_Settings);
+	for (auto & modName : mods) {
+		std::string fullPath = "Data\\MCM\\Config\\" + modName + "\\settings.ini";
 
-		} while (FindNextFile(hFind, &data));
-		FindClose(hFind);
+		// Read into settings
+		ReadINI(modName, fullPath);
 	}
 }
 
@@ -155,7 +196,7 @@ void SettingStore::LoadUserSettings() {
 		FindClose(hFind);
 	}
 
-	_MESSAGE("Number of mod setting files: %d", modSettingFiles.size());
+	MCM_LOG_MESSAGE("Number of mod setting files: %d", modSettingFiles.size());
 
 	for (int i = 0; i < modSettingFiles.size(); i++) {
 		std::string iniLocation = "./Data/MCM/Settings/";
@@ -171,14 +212,14 @@ void SettingStore::LoadUserSettings() {
 
 bool SettingStore::ReadINI(std::string modName, std::string iniLocation) {
 
-	//_MESSAGE("Loading mod settings for %s.", modName.c_str());
+	//MCM_LOG_MESSAGE("Loading mod settings for %s.", modName.c_str());
 
 	// Extract all sections
 	std::vector<std::string> sections;
 	LPTSTR lpszReturnBuffer = new TCHAR[1024];
 	DWORD sizeWritten = GetPrivateProfileSectionNames(lpszReturnBuffer, 1024, iniLocation.c_str());
 	if (sizeWritten == (1024 - 2)) {
-		_WARNING("Warning: Too many sections. Settings will not be read.");
+		MCM_LOG_WARNING("Warning: Too many sections. Settings will not be read.");
 		delete lpszReturnBuffer;
 		return false;
 	}
@@ -192,7 +233,7 @@ bool SettingStore::ReadINI(std::string modName, std::string iniLocation) {
 
 	delete lpszReturnBuffer;
 
-	//_MESSAGE("Number of sections: %d", sections.size());
+	//MCM_LOG_MESSAGE("Number of sections: %d", sections.size());
 
 	for (int j = 0; j < sections.size(); j++) {
 		// Extract all keys within section
@@ -205,13 +246,13 @@ bool SettingStore::ReadINI(std::string modName, std::string iniLocation) {
 			len <<= 1;
 			lpReturnedString = new TCHAR[len];
 			sizeWritten = GetPrivateProfileSection(sections[j].c_str(), lpReturnedString, len, iniLocation.c_str());
-			_MESSAGE("Expanded buffer to %d bytes.", len);
+			MCM_LOG_MESSAGE("Expanded buffer to %d bytes.", len);
 		}
 
 		for (LPTSTR p = lpReturnedString; *p; p++) {
 			std::string valuePair(p);
 
-			//_MESSAGE("%s", p);
+			//MCM_LOG_MESSAGE("%s", p);
 			auto delimiter = valuePair.find_first_of('=');
 			std::string settingName = valuePair.substr(0, delimiter) + ":" + sections[j];
 			/*if (sections[j] != "Main" && sections[j] != modName) {
@@ -232,7 +273,13 @@ bool SettingStore::ReadINI(std::string modName, std::string iniLocation) {
 
 Setting * SettingStore::GetModSetting(std::string modName, std::string settingName)
 {
-	auto itr = m_settingStore.find(modName + ":" + settingName);
+	WaitUntilLoaded();
+
+	// Names that were never interned cannot belong to a registered setting.
+	UInt64 key = MCMStringPool::GetInstance().FindKey(modName, settingName);
+	if (!key) return nullptr;
+
+	auto itr = m_settingStore.find(key);
 	if (itr != m_settingStore.end()) {
 		return itr->second;
 	}
@@ -241,8 +288,12 @@ Setting * SettingStore::GetModSetting(std::string modName, std::string settingNa
 
 void SettingStore::RegisterModSetting(std::string modName, std::string settingName, std::string settingValue)
 {
-	Setting* ms = new Setting;
+	MCMStringPool& pool = MCMStringPool::GetInstance();
+	MCMStringPool::StringID modID = pool.Intern(modName);
+	MCMStringPool::StringID settingID = pool.Intern(settingName);
 
+	// The pool keeps the first spelling of a name across all mods, so each setting keeps its own.
+	Setting* ms = new Setting;
 	char* nameCopy = new char[settingName.size()+1];
 	std::copy(settingName.begin(), settingName.end(), nameCopy);
 	nameCopy[settingName.size()] = '\0';
@@ -269,16 +320,27 @@ void SettingStore::RegisterModSetting(std::string modName, std::string settingNa
 		}
 
 		default:
-			_WARNING("WARNING: ModSetting %s from mod %s has an unknown type and cannot be registered.", settingName.c_str(), modName.c_str());
+			MCM_LOG_WARNING("WARNING: ModSetting %s from mod %s has an unknown type and cannot be registered.", settingName.c_str(), modName.c_str());
 			delete ms;
 			return;
 	}
 
-	m_settingStore[modName + ":" + settingName] = ms;
+	// User settings are registered over the defaults. The existing Setting is kept and only its value replaced,
+	// so pointers handed out by GetModSetting stay valid.
+	Setting*& entry = m_settingStore[MCMStringPool::MakeKey(modID, settingID)];
+	if (entry && entry->GetType() == ms->GetType()) {
+		std::swap(entry->data, ms->data);
+		delete ms;
+	} else {
+		delete entry;
+		entry = ms;
+	}
 }
 
 void SettingStore::CommitModSetting(std::string modName, Setting* modSetting)
 {
+	MCMPluginAPI::NotifySettingChanged(modName, modSetting->name);
+
 	std::string modSettingName(modSetting->name);
 	auto delimiter = modSettingName.find_first_of(':');
 	if (delimiter != std::string::npos) {
@@ -297,19 +359,22 @@ void SettingStore::CommitModSetting(std::string modName, Setting* modSetting)
 			value = std::to_string(modSetting->data.f32);
 			break;
 		case Setting::kType_String:
-			value = modSetting->data.s;
+			value = GetModSettingString(modSetting);
 			break;
 		default:
-			_WARNING("WARNING: ModSetting %s from mod %s has an unknown type and cannot be saved.", settingName.c_str(), modName.c_str());
+			MCM_LOG_WARNING("WARNING: ModSetting %s from mod %s has an unknown type and cannot be saved.", settingName.c_str(), modName.c_str());
 			return;
 		}
 
+		// Written on the I/O worker. Writes are applied in order, so the file always ends up with the latest value.
 		std::string iniPath = "./Data/MCM/Settings/" + modName + ".ini";
-		if (GetFileAttributes("Data\\MCM\\Settings") == INVALID_FILE_ATTRIBUTES)
-			CreateDirectory("Data\\MCM\\Settings", NULL);
-		WritePrivateProfileString(sectionName.c_str(), settingName.c_str(), value.c_str(), iniPath.c_str());
+		MCMIOWorker::GetInstance().Submit(MCMIOWorker::kPriority_Interactive, [sectionName, settingName, value, iniPath]() {
+			if (GetFileAttributes("Data\\MCM\\Settings") == INVALID_FILE_ATTRIBUTES)
+				CreateDirectory("Data\\MCM\\Settings", NULL);
+			WritePrivateProfileString(sectionName.c_str(), settingName.c_str(), value.c_str(), iniPath.c_str());
+		});
 	} else {
-		_WARNING("Error: Section could not be resolved.");
+		MCM_LOG_WARNING("Error: Section could not be resolved.");
 	}
 
 	
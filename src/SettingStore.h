@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include "f4se/GameSettings.h"
@@ -24,6 +28,9 @@ public:
 	}
 	void ReadSettings();
 
+	// Starts ReadSettings on the I/O worker. Accessors wait for it to finish on first use.
+	void ReadSettingsAsync();
+
 	SInt32 GetModSettingInt(std::string modName, std::string settingName);
 	void SetModSettingInt(std::string modName, std::string settingName, SInt32 newValue);
 	
@@ -33,18 +40,32 @@ public:
 	float GetModSettingFloat(std::string modName, std::string settingName);
 	void SetModSettingFloat(std::string modName, std::string settingName, float newValue);
 
-	char* GetModSettingString(std::string modName, std::string settingName);
+	// Returns a copy of the value, or an empty string if the setting does not exist.
+	std::string GetModSettingString(std::string modName, std::string settingName);
 	void SetModSettingString(std::string modName, std::string settingName, const char* newValue);
 
+	// Returns nullptr if the setting does not exist. Returned settings remain valid for the lifetime of the process.
+	Setting* GetModSetting(std::string modName, std::string settingName);
+
+	// Copies the value of a string setting into buffer, truncating it if necessary. Returns the length of the full value.
+	// Safe to call while the value is being changed on another thread.
+	UInt32 CopyModSettingString(Setting* modSetting, char* buffer, UInt32 bufferSize);
+	std::string GetModSettingString(Setting* modSetting);
+
 private:
 	SettingStore();
-	std::unordered_map<std::string, Setting*> m_settingStore;
+	std::unordered_map<UInt64, Setting*> m_settingStore;	// Keyed by MCMStringPool::MakeKey(modName, settingName).
+
+	std::shared_future<void>	m_loadTask;
+	std::atomic<bool>			m_loaded	{ true };
+	std::mutex					m_stringLock;	// Guards replacement of string values.
+
+	void WaitUntilLoaded();
 
 	bool ReadINI(std::string modName, std::string iniLocation);
 	void LoadDefaults();
 	void LoadUserSettings();
 
-	Setting* GetModSetting(std::string modName, std::string settingName);
 	void RegisterModSetting(std::string modName, std::string settingName, std::string settingValue);
 	void CommitModSetting(std::string modName, Setting* modSetting);
 
@@ -1,15 +1,19 @@
 #include "Utils.h"
 #include "Config.h"
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "f4se_common/SafeWrite.h"
 #include "f4se/GameData.h"
 #include "f4se/PapyrusVM.h"
 #include "f4se/PapyrusArgs.h"
+#include "f4se/GameRTTI.h"
 
 #include "rva/RVA.h"
 #include "Globals.h"
+#include "MCMLog.h"
 
 //---------------------
 // Function Signatures
@@ -102,6 +106,23 @@ std::string MCMUtils::GetIdentifierFromFormID(UInt32 formID)
 	return "";
 }
 
+TESGlobal * MCMUtils::GetGlobalFromIdentifier(const std::string & identifier)
+{
+	static std::mutex lock;
+	static std::unordered_map<std::string, TESGlobal*> globalCache;
+
+	std::lock_guard<std::mutex> guard(lock);
+	auto itr = globalCache.find(identifier);
+	if (itr != globalCache.end()) return itr->second;
+
+	TESForm* form = GetFormFromIdentifier(identifier);
+	TESGlobal* global = DYNAMIC_CAST(form, TESForm, TESGlobal);
+
+	// Forms are never unloaded, so only successful lookups need to be cached.
+	if (global) globalCache[identifier] = global;
+	return global;
+}
+
 void MCMUtils::ExecuteCommand(const char * cmd)
 {
 	ExecuteCommand_Internal(cmd);
@@ -127,7 +148,7 @@ bool MCMUtils::GetPropertyValue(const char * formIdentifier, const char * script
 {
 	TESForm* targetForm = MCMUtils::GetFormFromIdentifier(formIdentifier);
 	if (!targetForm) {
-		_WARNING("Warning: Cannot retrieve property value %s from a None form. (%s)", propertyName, formIdentifier);
+		MCM_LOG_WARNING("Warning: Cannot retrieve property value %s from a None form. (%s)", propertyName, formIdentifier);
 		return false;
 	}
 
@@ -135,7 +156,7 @@ bool MCMUtils::GetPropertyValue(const char * formIdentifier, const char * script
 	VMScript script(targetForm, scriptName);
 
 	if (!script.m_identifier) {
-		_WARNING("Warning: Cannot retrieve a property value %s from a form with no scripts attached. (%s)", propertyName, formIdentifier);
+		MCM_LOG_WARNING("Warning: Cannot retrieve a property value %s from a form with no scripts attached. (%s)", propertyName, formIdentifier);
 		return false;
 	}
 
@@ -148,7 +169,7 @@ bool MCMUtils::GetPropertyValue(const char * formIdentifier, const char * script
 		vm->GetPropertyValueByIndex(&script.m_identifier, pInfo.index, valueOut);
 		return true;
 	} else {
-		_WARNING("Warning: Property %s does not exist on script %s", propertyName, script.m_identifier->m_typeInfo->m_typeName.c_str());
+		MCM_LOG_WARNING("Warning: Property %s does not exist on script %s", propertyName, script.m_identifier->m_typeInfo->m_typeName.c_str());
 		return false;
 	}
 }
@@ -157,7 +178,7 @@ bool MCMUtils::SetPropertyValue(const char * formIdentifier, const char * script
 {
 	TESForm* targetForm = GetFormFromIdentifier(formIdentifier);
 	if (!targetForm) {
-		_WARNING("Warning: Cannot set property %s on a None form. (%s)", propertyName, formIdentifier);
+		MCM_LOG_WARNING("Warning: Cannot set property %s on a None form. (%s)", propertyName, formIdentifier);
 		return false;
 	}
 
@@ -165,7 +186,7 @@ bool MCMUtils::SetPropertyValue(const char * formIdentifier, const char * script
 	VMScript script(targetForm, scriptName);
 
 	if (!script.m_identifier) {
-		_WARNING("Warning: Cannot set a property value %s on a form with no scripts attached. (%s)", propertyName, formIdentifier);
+		MCM_LOG_WARNING("Warning: Cannot set a property value %s on a form with no scripts attached. (%s)", propertyName, formIdentifier);
 		return false;
 	}
 
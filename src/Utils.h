@@ -26,6 +26,9 @@ namespace MCMUtils {
 	std::string GetIdentifierFromForm(const TESForm & form);
 	std::string GetIdentifierFromFormID(UInt32 formID);
 
+	// Resolves a TESGlobal from a form identifier. Results are cached, so repeated lookups skip identifier parsing and the cast.
+	TESGlobal * GetGlobalFromIdentifier(const std::string & identifier);
+
 	// Console Commands
 	void ExecuteCommand(const char* cmd);
 
@@ -556,6 +556,93 @@ enum CommentPlacement {
 //   typedef CppTL::AnyEnumerator<const Value &> EnumValues;
 //# endif
 
+/** \brief Monotonic arena for the allocations of a Value tree.
+ *
+ * While a ScopedValueArena is active on a thread, every string, member key,
+ * object/array map and map node allocated by a Value on that thread is carved
+ * out of the arena instead of the heap. Releasing these allocations is a no-op;
+ * the memory is returned in one shot when the arena is destroyed.
+ *
+ * Arena memory is placed at addresses that are 8 modulo 16, which the heap
+ * never returns on 64-bit targets, so release() can tell the two apart without
+ * a per-allocation header. Values built in an arena may therefore still be
+ * modified or destroyed after the scope ends. The arena itself must outlive
+ * every Value allocated from it, and is not thread-safe.
+ *
+ * \code
+ * Json::ValueArena arena;
+ * Json::ScopedValueArena scope(arena);
+ * Json::Value root;   // Declared after the arena so it is destroyed first.
+ * reader.parse(file, root);
+ * \endcode
+ */
+class JSON_API ValueArena {
+public:
+  ValueArena();
+  ~ValueArena();
+
+  /// Allocates from the current thread's arena, or from the heap if none is active.
+  /// Arena memory is only 8-byte aligned.
+  static void* allocate(size_t size);
+  /// Releases memory returned by allocate(). Arena memory is left in place.
+  static void release(void* p);
+
+private:
+  ValueArena(ValueArena const&);
+  ValueArena& operator=(ValueArena const&);
+
+  struct Block;
+  void* allocateFromBlocks(size_t size);
+
+  Block* blocks_;
+  char* cursor_;
+  char* end_;
+
+  friend class ScopedValueArena;
+};
+
+/** \brief Makes an arena the current arena of this thread for its lifetime.
+ * Scopes may be nested; the previous arena is restored on destruction.
+ */
+class JSON_API ScopedValueArena {
+public:
+  explicit ScopedValueArena(ValueArena& arena);
+  ~ScopedValueArena();
+
+private:
+  ScopedValueArena(ScopedValueArena const&);
+  ScopedValueArena& operator=(ScopedValueArena const&);
+
+  ValueArena* previous_;
+};
+
+/** \brief Standard allocator backed by ValueArena::allocate().
+ * Used for the map nodes of object and array Values.
+ *
+ * The allocator is stateless: release() works out from the address whether
+ * memory came from an arena or the heap, so any instance can free memory
+ * allocated by any other. That is why all instances compare equal, even when
+ * they were used under different arenas.
+ */
+template <typename T> class ValueAllocator {
+public:
+  typedef T value_type;
+
+  ValueAllocator() {}
+  template <typename U> ValueAllocator(ValueAllocator<U> const&) {}
+
+  T* allocate(size_t n) {
+    static_assert(__alignof(T) <= 8, "ValueArena memory is only 8-byte aligned");
+    return static_cast<T*>(ValueArena::allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) { ValueArena::release(p); }
+
+  template <typename U> struct rebind { typedef ValueAllocator<U> other; };
+
+  template <typename U> bool operator==(ValueAllocator<U> const&) const { return true; }
+  template <typename U> bool operator!=(ValueAllocator<U> const&) const { return false; }
+};
+
 /** \brief Lightweight wrapper to tag static string.
  *
  * Value constructor and objectValue member assignement takes advantage of the
@@ -701,7 +788,7 @@ private:
 
 public:
 #ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+  typedef std::map<CZString, Value, std::less<CZString>, ValueAllocator<std::pair<const CZString, Value> > > ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
@@ -2550,7 +2550,7 @@ static inline char* duplicateStringValue(const char* value,
   if (length >= static_cast<size_t>(Value::maxInt))
     length = Value::maxInt - 1;
 
-  char* newString = static_cast<char*>(malloc(length + 1));
+  char* newString = static_cast<char*>(ValueArena::allocate(length + 1));
   if (newString == NULL) {
     throwRuntimeError(
         "in Json::Value::duplicateStringValue(): "
@@ -2573,7 +2573,7 @@ static inline char* duplicateAndPrefixStringValue(
                       "in Json::Value::duplicateAndPrefixStringValue(): "
                       "length too big for prefixing");
   unsigned actualLength = length + static_cast<unsigned>(sizeof(unsigned)) + 1U;
-  char* newString = static_cast<char*>(malloc(actualLength));
+  char* newString = static_cast<char*>(ValueArena::allocate(actualLength));
   if (newString == 0) {
     throwRuntimeError(
         "in Json::Value::duplicateAndPrefixStringValue(): "
@@ -2605,23 +2605,137 @@ static inline void releasePrefixedStringValue(char* value) {
   decodePrefixedString(true, value, &length, &valueDecoded);
   size_t const size = sizeof(unsigned) + length + 1U;
   memset(value, 0, size);
-  free(value);
+  ValueArena::release(value);
 }
 static inline void releaseStringValue(char* value, unsigned length) {
   // length==0 => we allocated the strings memory
   size_t size = (length==0) ? strlen(value) : length;
   memset(value, 0, size);
-  free(value);
+  ValueArena::release(value);
 }
 #else // !JSONCPP_USING_SECURE_MEMORY
 static inline void releasePrefixedStringValue(char* value) {
-  free(value);
+  ValueArena::release(value);
 }
 static inline void releaseStringValue(char* value, unsigned) {
-  free(value);
+  ValueArena::release(value);
 }
 #endif // JSONCPP_USING_SECURE_MEMORY
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class ValueArena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Heap allocations are 16-byte aligned on 64-bit targets. Arena allocations
+// are kept at 8 modulo 16, so release() can tell them apart by address alone
+// and neither kind needs a header.
+static_assert(sizeof(void*) == 8, "ValueArena relies on 16-byte aligned heap allocations");
+static const size_t kArenaAlignment = 16;
+static const size_t kArenaOffset = 8;
+static const size_t kArenaBlockSize = 64 * 1024;
+
+struct ValueArena::Block {
+  Block* next;
+};
+
+#if defined(_MSC_VER)
+static __declspec(thread) ValueArena* currentArena = 0;
+#else
+static thread_local ValueArena* currentArena = 0;
+#endif
+
+static inline bool isArenaPointer(void* p) {
+  return (reinterpret_cast<size_t>(p) & (kArenaAlignment - 1)) == kArenaOffset;
+}
+
+ValueArena::ValueArena() : blocks_(0), cursor_(0), end_(0) {}
+
+ValueArena::~ValueArena() {
+  while (blocks_) {
+    Block* next = blocks_->next;
+    free(blocks_);
+    blocks_ = next;
+  }
+}
+
+void* ValueArena::allocateFromBlocks(size_t size) {
+  // Rounding every size to the alignment keeps the cursor at kArenaOffset.
+  size = (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+
+  // Large allocations get a block of their own, so they do not waste the rest of the current block.
+  if (size > kArenaBlockSize / 4) {
+    Block* block = static_cast<Block*>(malloc(kArenaOffset + size));
+    if (block == 0) return 0;
+    if (blocks_) {
+      block->next = blocks_->next;
+      blocks_->next = block;
+    } else {
+      block->next = 0;
+      blocks_ = block;
+    }
+    return reinterpret_cast<char*>(block) + kArenaOffset;
+  }
+
+  if (cursor_ == 0 || static_cast<size_t>(end_ - cursor_) < size) {
+    Block* block = static_cast<Block*>(malloc(kArenaBlockSize));
+    if (block == 0) return 0;
+    block->next = blocks_;
+    blocks_ = block;
+    cursor_ = reinterpret_cast<char*>(block) + kArenaOffset;
+    end_ = reinterpret_cast<char*>(block) + kArenaBlockSize;
+  }
+
+  void* p = cursor_;
+  cursor_ += size;
+  return p;
+}
+
+void* ValueArena::allocate(size_t size) {
+  ValueArena* arena = currentArena;
+  return arena ? arena->allocateFromBlocks(size) : malloc(size);
+}
+
+void ValueArena::release(void* p) {
+  if (p == 0 || isArenaPointer(p)) return;
+  free(p);
+}
+
+ScopedValueArena::ScopedValueArena(ValueArena& arena) : previous_(currentArena) {
+  currentArena = &arena;
+}
+
+ScopedValueArena::~ScopedValueArena() {
+  currentArena = previous_;
+}
+
+static Value::ObjectValues* newObjectValues() {
+  void* p = ValueArena::allocate(sizeof(Value::ObjectValues));
+  if (p == 0) throwRuntimeError("in Json::Value: Failed to allocate object value map");
+  return new (p) Value::ObjectValues();
+}
+
+static Value::ObjectValues* newObjectValues(Value::ObjectValues const& other) {
+  void* p = ValueArena::allocate(sizeof(Value::ObjectValues));
+  if (p == 0) throwRuntimeError("in Json::Value: Failed to allocate object value map");
+  try {
+    return new (p) Value::ObjectValues(other);
+  } catch (...) {
+    ValueArena::release(p);
+    throw;
+  }
+}
+
+static void deleteObjectValues(Value::ObjectValues* map) {
+  typedef Value::ObjectValues ObjectValues;
+  if (map == 0) return;
+  map->~ObjectValues();
+  ValueArena::release(map);
+}
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////
@@ -2809,7 +2923,7 @@ Value::Value(ValueType vtype) {
     break;
   case arrayValue:
   case objectValue:
-    value_.map_ = new ObjectValues();
+    value_.map_ = newObjectValues();
     break;
   case booleanValue:
     value_.bool_ = false;
@@ -2907,7 +3021,7 @@ Value::Value(Value const& other)
     break;
   case arrayValue:
   case objectValue:
-    value_.map_ = new ObjectValues(*other.value_.map_);
+    value_.map_ = newObjectValues(*other.value_.map_);
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
@@ -2945,7 +3059,7 @@ Value::~Value() {
     break;
   case arrayValue:
   case objectValue:
-    delete value_.map_;
+    deleteObjectValues(value_.map_);
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
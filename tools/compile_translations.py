@@ -0,0 +1,98 @@
+"""Compiles MCM translation files into the table format cached by the plugin.
+
+Usage: python tools/compile_translations.py <mod>_en.txt [<mod>_<lang>.txt] <output.bin>
+
+The output is equivalent to the Data\\MCM\\Cache\\Translations\\<mod>_<lang>.bin file that the plugin writes on
+first load, so it can be generated ahead of time on any platform. Keep in sync with MCMTranslator.cpp.
+"""
+
+import array, struct, sys
+
+MAGIC   = 0x544D434D  # "MCMT"
+VERSION = 1
+
+
+def fnv1a64(hash, data):
+    for b in data:
+        hash ^= b
+        hash = (hash * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return hash
+
+
+def hash_sources(base, locale):
+    hash = 14695981039346656037
+    for data in (base, locale):
+        hash = fnv1a64(hash, struct.pack('<Q', len(data)))
+        hash = fnv1a64(hash, data)
+    return hash
+
+
+def parse(data):
+    """Returns a list of (key, translation) pairs. Accepts UCS-2 LE with a BOM, or UTF-8."""
+    if data[:2] == b'\xff\xfe':
+        units = array.array('H')
+        units.frombytes(data[2:len(data) - (len(data) % 2)])
+        if sys.byteorder != 'little':
+            units.byteswap()
+        text = units.tobytes().decode('utf-16-le', 'surrogatepass')
+    elif data[:2] == b'\xfe\xff':
+        raise ValueError('file must be encoded in UCS-2 LE or UTF-8')
+    else:
+        text = data.decode('utf-8-sig')
+
+    entries = []
+    for line in text.split('\n'):
+        if line.endswith('\r'):
+            line = line[:-1]
+        # at least $ + char + \t + char, and the key ends at the last tab
+        if len(line) < 4 or line[0] != '$':
+            continue
+        delim = line.rfind('\t')
+        if delim < 2:
+            continue
+        entries.append((line[:delim], line[delim + 1:]))
+    return entries
+
+
+def merge(base, overrides):
+    merged = {}
+    for key, translation in base + overrides:
+        merged[key] = translation  # dicts keep first-insertion order
+    return list(merged.items())
+
+
+def write_table(path, source_hash, entries):
+    text = array.array('H')
+    offsets = []
+    for key, translation in entries:
+        key_offset = len(text)
+        text.frombytes((key + '\0').encode('utf-16-le', 'surrogatepass'))
+        offsets.append((key_offset, len(text)))
+        text.frombytes((translation + '\0').encode('utf-16-le', 'surrogatepass'))
+    if sys.byteorder != 'little':
+        text.byteswap()
+
+    with open(path, 'wb') as f:
+        f.write(struct.pack('<IIQII', MAGIC, VERSION, source_hash, len(offsets), len(text)))
+        for key_offset, translation_offset in offsets:
+            f.write(struct.pack('<II', key_offset, translation_offset))
+        f.write(text.tobytes())
+
+
+def main(args):
+    if len(args) not in (2, 3):
+        print(__doc__)
+        return 1
+
+    sources = [open(path, 'rb').read() for path in args[:-1]]
+    base = sources[0]
+    locale = sources[1] if len(sources) > 1 else b''
+
+    entries = merge(parse(base), parse(locale) if locale else [])
+    write_table(args[-1], hash_sources(base, locale), entries)
+    print('Compiled {} translations to {}'.format(len(entries), args[-1]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
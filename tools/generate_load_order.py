@@ -0,0 +1,269 @@
+"""Generates a synthetic MCM load order for testing the plugin at scale.
+
+Usage: python tools/generate_load_order.py <output dir> [--mods 10,100,1000,5000] [--seed N] [options]
+
+For each mod count, a game-relative tree is written to <output dir>/<count>/Data:
+
+    MCM/Config/<mod>/config.json        pages of controls bound to ModSettings, globals and properties
+    MCM/Config/<mod>/settings.ini       defaults for every ModSetting control
+    MCM/Config/<mod>/keybinds.json      keybind definitions
+    MCM/Settings/<mod>.ini              user overrides for a fraction of the settings
+    MCM/Settings/Keybinds.json          stored keybinds for a fraction of the definitions
+    Interface/Translations/<mod>_<lang>.txt
+
+Copy (or junction) a tree over a test install's Data directory and compare the timings written to MCM.log.
+Output is fully determined by the seed and options, so runs can be repeated across builds.
+Keep the file formats in sync with SettingStore.cpp, MCMKeybinds.cpp and MCMTranslator.cpp.
+"""
+
+import argparse, io, json, math, os, random, sys
+
+SETTING_TYPES = (
+    # (prefix, sourceType, control type)
+    ('b', 'ModSettingBool',   'switcher'),
+    ('i', 'ModSettingInt',    'stepper'),
+    ('f', 'ModSettingFloat',  'slider'),
+    ('s', 'ModSettingString', 'textinputModSetting'),
+)
+
+ACTION_TYPES = ('CallFunction', 'CallGlobalFunction', 'RunConsoleCommand', 'SendEvent')
+
+WORDS = ('Enable', 'Combat', 'Loot', 'Weapon', 'Armor', 'Power', 'Settler', 'Workshop', 'Radio', 'Vault',
+         'Damage', 'Speed', 'Range', 'Scale', 'Timer', 'Sound', 'Light', 'Color', 'Debug', 'Camera')
+
+DIK_CODES = list(range(2, 12)) + list(range(16, 26)) + list(range(30, 39)) + list(range(44, 51)) + list(range(59, 69))
+
+
+def sized(rng, mean, spread):
+    """Draws a non-negative count from a log-normal distribution, so most mods are small and a few are large."""
+    if mean <= 0:
+        return 0
+    mu = math.log(mean) - spread * spread / 2
+    return max(0, int(round(rng.lognormvariate(mu, spread))))
+
+
+def make_name(rng, words):
+    return ''.join(rng.choice(WORDS) for _ in range(words))
+
+
+def form_id(rng, plugin):
+    return '{}|{:X}'.format(plugin, rng.randint(0x800, 0xFFFFF))
+
+
+class Mod(object):
+    def __init__(self, rng, index, opts):
+        self.name = 'SynthMod{:05d}{}'.format(index, make_name(rng, 1))
+        self.plugin = self.name + '.esp'
+        self.settings = []      # (id, prefix, section, default)
+        self.keybinds = []      # (id, desc, action)
+        self.pages = []         # (name, [controls])
+
+        sections = ['Main'] + [make_name(rng, 1) for _ in range(rng.randint(0, 3))]
+        names = set()
+        for _ in range(sized(rng, opts.settings, opts.spread)):
+            prefix = rng.choice(SETTING_TYPES)[0]
+            name = prefix + make_name(rng, 2)
+            section = rng.choice(sections)
+            setting_id = '{}:{}'.format(name, section)
+            if setting_id in names:
+                continue
+            names.add(setting_id)
+            self.settings.append((setting_id, prefix, section, self.default_value(rng, prefix)))
+
+        for k in range(sized(rng, opts.keybinds, opts.spread)):
+            self.keybinds.append(('{}_{}'.format(make_name(rng, 1), k), '$' + self.name + '_Keybind' + str(k),
+                                  self.make_action(rng)))
+
+        controls = [self.setting_control(rng, s) for s in self.settings]
+        controls += [self.other_control(rng) for _ in range(sized(rng, opts.settings / 4.0, opts.spread))]
+        rng.shuffle(controls)
+        page_count = max(1, min(len(controls) // 12, opts.max_pages))
+        for p in range(page_count):
+            self.pages.append(('$' + self.name + '_Page' + str(p), controls[p::page_count]))
+
+    @staticmethod
+    def default_value(rng, prefix):
+        if prefix == 'b':
+            return str(rng.randint(0, 1))
+        if prefix == 'i':
+            return str(rng.randint(-100, 1000))
+        if prefix == 'f':
+            return '{:.6f}'.format(rng.uniform(0, 100))
+        return make_name(rng, rng.randint(1, 4))
+
+    def setting_control(self, rng, setting):
+        setting_id, prefix, _, _ = setting
+        source_type, control_type = next((t[1], t[2]) for t in SETTING_TYPES if t[0] == prefix)
+        control = {
+            'text': '$' + self.name + '_' + setting_id.split(':')[0],
+            'type': control_type,
+            'id': setting_id,
+            'valueOptions': {'sourceType': source_type},
+        }
+        if prefix in 'if':
+            control['valueOptions'].update({'min': 0, 'max': 100, 'step': 1})
+        return control
+
+    def other_control(self, rng):
+        kind = rng.random()
+        if kind < 0.4:
+            return {'text': '$' + self.name + '_' + make_name(rng, 2), 'type': 'section'}
+        if kind < 0.6:
+            return {'type': 'spacer', 'numLines': 1}
+        if kind < 0.8:
+            return {'text': make_name(rng, 2), 'type': 'slider',
+                    'valueOptions': {'min': 0, 'max': 10, 'step': 1, 'sourceType': 'GlobalValue',
+                                     'sourceForm': form_id(rng, self.plugin)}}
+        return {'text': make_name(rng, 2), 'type': 'switcher',
+                'valueOptions': {'sourceType': 'PropertyValueBool', 'sourceForm': form_id(rng, self.plugin),
+                                 'scriptName': self.name + '_Quest', 'propertyName': make_name(rng, 2)}}
+
+    def make_action(self, rng):
+        action_type = rng.choice(ACTION_TYPES)
+        if action_type == 'RunConsoleCommand':
+            return {'type': action_type, 'command': 'player.additem f {}'.format(rng.randint(1, 100))}
+        action = {'type': action_type, 'function': 'On' + make_name(rng, 2)}
+        if action_type == 'CallGlobalFunction':
+            action['script'] = self.name + '_Global'
+        else:
+            action['form'] = form_id(rng, self.plugin)
+        params = []
+        for _ in range(rng.randint(0, 3)):
+            params.append(rng.choice((rng.randint(0, 100), rng.uniform(0, 1), rng.random() < 0.5, make_name(rng, 1))))
+        if params:
+            action['params'] = params
+        return action
+
+    def config(self):
+        root = {'modName': self.name, 'displayName': self.name, 'minMcmVersion': 2,
+                'content': [{'text': '$' + self.name + '_Title', 'type': 'section'}]}
+        root['pages'] = [{'pageDisplayName': name, 'content': controls} for name, controls in self.pages]
+        return root
+
+    def translations(self):
+        strings = [('$' + self.name + '_Title', self.name)]
+        strings += [(name, name[1:].replace('_', ' ')) for name, _ in self.pages]
+        for _, controls in self.pages:
+            strings += [(c['text'], c['text'][1:].replace('_', ' ')) for c in controls
+                        if c.get('text', '').startswith('$')]
+        strings += [(desc, desc[1:].replace('_', ' ')) for _, desc, _ in self.keybinds]
+        return strings
+
+
+def write_ini(path, entries):
+    """entries: [(section, key, value)] in file order."""
+    sections = {}
+    order = []
+    for section, key, value in entries:
+        if section not in sections:
+            sections[section] = []
+            order.append(section)
+        sections[section].append((key, value))
+    with io.open(path, 'w', encoding='ascii', newline='\r\n') as f:
+        for section in order:
+            f.write(u'[{}]\n'.format(section))
+            for key, value in sections[section]:
+                f.write(u'{}={}\n'.format(key, value))
+            f.write(u'\n')
+
+
+def write_json(path, value, pretty):
+    with io.open(path, 'w', encoding='utf-8', newline='\r\n') as f:
+        f.write(json.dumps(value, indent=4 if pretty else None, ensure_ascii=False))
+
+
+def write_translations(path, strings, localize):
+    """Writes a UCS-2 LE translation file with a BOM, as shipped by most mods."""
+    lines = [u'{}\t{}'.format(key, localize(text)) for key, text in strings]
+    with open(path, 'wb') as f:
+        f.write(b'\xff\xfe')
+        f.write(u'\r\n'.join(lines).encode('utf-16-le'))
+
+
+def generate(out_dir, count, opts):
+    rng = random.Random('{}:{}'.format(opts.seed, count))
+    data = os.path.join(out_dir, str(count), 'Data')
+    config_dir = os.path.join(data, 'MCM', 'Config')
+    settings_dir = os.path.join(data, 'MCM', 'Settings')
+    translations_dir = os.path.join(data, 'Interface', 'Translations')
+    for d in (config_dir, settings_dir, translations_dir):
+        if not os.path.isdir(d):
+            os.makedirs(d)
+
+    stored_keybinds = []
+    used_keys = set()
+    totals = {'settings': 0, 'keybinds': 0, 'user': 0, 'translations': 0}
+
+    for index in range(count):
+        mod = Mod(rng, index, opts)
+        mod_dir = os.path.join(config_dir, mod.name)
+        if not os.path.isdir(mod_dir):
+            os.makedirs(mod_dir)
+
+        write_json(os.path.join(mod_dir, 'config.json'), mod.config(), rng.random() < opts.pretty)
+        if mod.settings:
+            write_ini(os.path.join(mod_dir, 'settings.ini'),
+                      [(section, sid.split(':')[0], value) for sid, _, section, value in mod.settings])
+            overrides = [s for s in mod.settings if rng.random() < opts.user_settings]
+            if overrides:
+                write_ini(os.path.join(settings_dir, mod.name + '.ini'),
+                          [(section, sid.split(':')[0], Mod.default_value(rng, prefix))
+                           for sid, prefix, section, _ in overrides])
+                totals['user'] += len(overrides)
+        if mod.keybinds:
+            write_json(os.path.join(mod_dir, 'keybinds.json'),
+                       {'modName': mod.name,
+                        'keybinds': [{'id': kid, 'desc': desc, 'action': action} for kid, desc, action in mod.keybinds]},
+                       rng.random() < opts.pretty)
+            for kid, _, _ in mod.keybinds:
+                if rng.random() >= opts.stored_keybinds:
+                    continue
+                key = (rng.choice(DIK_CODES), rng.choice((0, 0, 0, 1, 2, 4)))
+                if key in used_keys:
+                    continue
+                used_keys.add(key)
+                stored_keybinds.append({'keycode': key[0], 'modifiers': key[1], 'modName': mod.name, 'id': kid})
+
+        strings = mod.translations()
+        write_translations(os.path.join(translations_dir, mod.name + '_en.txt'), strings, lambda text: text)
+        for lang in opts.languages:
+            write_translations(os.path.join(translations_dir, '{}_{}.txt'.format(mod.name, lang)), strings,
+                               lambda text, lang=lang: u'[{}] {}'.format(lang, text))
+
+        totals['settings'] += len(mod.settings)
+        totals['keybinds'] += len(mod.keybinds)
+        totals['translations'] += len(strings)
+
+    write_json(os.path.join(settings_dir, 'Keybinds.json'), {'version': 1, 'keybinds': stored_keybinds}, True)
+
+    print('{} mods: {settings} settings ({user} overridden), {keybinds} keybinds ({stored} stored), '
+          '{translations} translation strings -> {path}'.format(count, stored=len(stored_keybinds), path=data, **totals))
+
+
+def main(args):
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('output', help='directory to write the generated trees to')
+    parser.add_argument('--mods', default='10,100,1000,5000', help='comma-separated mod counts (default: %(default)s)')
+    parser.add_argument('--seed', type=int, default=1, help='random seed (default: %(default)s)')
+    parser.add_argument('--settings', type=float, default=20, help='mean ModSettings per mod (default: %(default)s)')
+    parser.add_argument('--keybinds', type=float, default=3, help='mean keybinds per mod (default: %(default)s)')
+    parser.add_argument('--spread', type=float, default=1.0,
+                        help='log-normal sigma for per-mod counts; 0 makes every mod the same size (default: %(default)s)')
+    parser.add_argument('--max-pages', type=int, default=8, help='maximum pages per config.json (default: %(default)s)')
+    parser.add_argument('--user-settings', type=float, default=0.3,
+                        help='fraction of settings overridden in MCM/Settings (default: %(default)s)')
+    parser.add_argument('--stored-keybinds', type=float, default=0.5,
+                        help='fraction of keybinds bound in Keybinds.json (default: %(default)s)')
+    parser.add_argument('--pretty', type=float, default=0.7,
+                        help='fraction of JSON files written indented rather than minified (default: %(default)s)')
+    parser.add_argument('--languages', default='de,fr', help='comma-separated translation languages besides en')
+    opts = parser.parse_args(args)
+    opts.languages = [lang for lang in opts.languages.split(',') if lang and lang != 'en']
+
+    for count in (int(c) for c in opts.mods.split(',')):
+        generate(opts.output, count, opts)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))